@@ -0,0 +1,119 @@
+#include "WiFiFSCore.h"
+#include <stdlib.h>
+#include <ctype.h>
+
+namespace wififs {
+
+const MimeRule MIME_TABLE[] = {
+    {"htm",  "text/html", 0},
+    {"html", "text/html", 0},
+    {"css",  "text/css", 86400},
+    {"js",   "application/javascript", 86400},
+    {"json", "application/json", 0},
+    {"txt",  "text/plain", 0},
+    {"csv",  "text/plain", 0},
+    {"ini",  "text/plain", 0},
+    {"png",  "image/png", 604800},
+    {"gif",  "image/gif", 604800},
+    {"jpg",  "image/jpeg", 604800},
+    {"jpeg", "image/jpeg", 604800},
+    {"ico",  "image/x-icon", 604800},
+    {"svg",  "image/svg+xml", 604800},
+    {"gz",   "application/x-gzip", 0},
+    {"",     "application/octet-stream", 0},
+};
+const uint8_t MIME_DEFAULT = sizeof(MIME_TABLE)/sizeof(MIME_TABLE[0]) - 1;
+
+const char TPL_FILE_ROW[] =
+"<tr><td><a href='/view?path=%PATH%'>%PATH%</a></td><td>%SIZE%</td><td><form method='POST' action='/delete' style='display:inline'>"
+"<input type='hidden' name='path' value='%SAFEPATH%'><button type='submit' class='danger'>Usuń</button></form> "
+"<form method='POST' action='/rename' style='display:inline'><input type='hidden' name='from' value='%PATH%'><input type='text' name='to' value='%PATH%' size='16'>"
+"<button type='submit'>Zmień nazwę</button></form> <a href='%PATH%' download>Pobierz</a></td></tr>";
+
+uint8_t mimeIndexFor(const char* path, size_t len) {
+    size_t dot = len;
+    while (dot > 0 && path[dot-1] != '.' && path[dot-1] != '/') dot--;
+    if (dot == 0 || path[dot-1] != '.') return MIME_DEFAULT;
+    char ext[8]; size_t n = len - dot;
+    if (n == 0 || n >= sizeof(ext)) return MIME_DEFAULT;
+    for (size_t i = 0; i < n; i++) ext[i] = tolower((unsigned char)path[dot+i]);
+    ext[n] = 0;
+    for (uint8_t i = 0; i < MIME_DEFAULT; i++) if (!strcmp(ext, MIME_TABLE[i].ext)) return i;
+    return MIME_DEFAULT;
+}
+
+// Liczba dziesiętna z samych cyfr, po niej tylko spacje aż do end (albo do końca napisu, gdy end == nullptr)
+static bool parseRangeNum(const char* p, const char* end, size_t& v) {
+    if (!isdigit((unsigned char)*p)) return false;
+    char* e; v = strtoul(p, &e, 10);
+    while (*e == ' ') e++;
+    return end ? e == end : *e == 0;
+}
+
+int parseRange(const char* h, size_t size, size_t& start, size_t& len) {
+    if (strncmp(h, "bytes=", 6) != 0 || strchr(h, ',')) return 0;
+    const char* a = h + 6;
+    while (*a == ' ') a++;
+    const char* dash = strchr(a, '-'); if (!dash) return 0;
+    const char* b = dash + 1;
+    while (*b == ' ') b++;
+    bool hasFirst = a != dash, hasLast = *b != 0;
+    if (!hasFirst) {
+        if (!hasLast) return 0;
+        size_t n; if (!parseRangeNum(b, nullptr, n)) return 0;
+        if (n == 0 || size == 0) return -1;
+        if (n > size) n = size;
+        start = size - n; len = n; return 1;
+    }
+    size_t first, last = size - 1;
+    if (!parseRangeNum(a, dash, first) || (hasLast && !parseRangeNum(b, nullptr, last))) return 0;
+    if (first >= size) return -1;
+    if (last < first) return 0;
+    if (last >= size) last = size - 1;
+    start = first; len = last - first + 1; return 1;
+}
+
+uint32_t crc32(uint32_t crc, const uint8_t* p, size_t n) {
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++) {
+        crc ^= p[i];
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+static void put16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void put32(uint8_t* p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+static uint16_t get16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t get32(const uint8_t* p) { return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+bool ConfigWriter::put(const char* key, const char* val, size_t vlen) {
+    size_t klen = strlen(key);
+    if (!_ok || klen > 255 || vlen > 0xFFFF || _len + 1 + klen + 2 + vlen > _cap || _len + 1 + klen + 2 + vlen - CONFIG_HEADER_SIZE > 0xFFFF) { _ok = false; return false; }
+    _buf[_len++] = klen;
+    memcpy(_buf + _len, key, klen); _len += klen;
+    put16(_buf + _len, vlen); _len += 2;
+    memcpy(_buf + _len, val, vlen); _len += vlen;
+    return true;
+}
+
+size_t ConfigWriter::finish(uint32_t seq) {
+    if (!_ok) return 0;
+    put32(_buf, CONFIG_MAGIC);
+    put16(_buf + 4, CONFIG_VERSION);
+    put16(_buf + 6, _len - CONFIG_HEADER_SIZE);
+    put32(_buf + 8, seq);
+    put32(_buf + 12, crc32(crc32(0, _buf + 4, 8), payload(), payloadLen()));
+    return _len;
+}
+
+bool parseConfigRecord(const uint8_t* buf, size_t len, uint32_t& seq, const uint8_t*& payload, size_t& payloadLen) {
+    if (len < CONFIG_HEADER_SIZE || get32(buf) != CONFIG_MAGIC || get16(buf + 4) != CONFIG_VERSION) return false;
+    size_t n = get16(buf + 6);
+    if (CONFIG_HEADER_SIZE + n > len) return false;
+    if (crc32(crc32(0, buf + 4, 8), buf + CONFIG_HEADER_SIZE, n) != get32(buf + 12)) return false;
+    seq = get32(buf + 8); payload = buf + CONFIG_HEADER_SIZE; payloadLen = n;
+    return true;
+}
+
+} // namespace wififs
@@ -0,0 +1,87 @@
+#pragma once
+// Logika ścieżek żądań niezależna od Arduino/ESP-IDF (tylko libc), dzięki czemu
+// ten moduł kompiluje się również na hoście, np. na potrzeby pomiarów i testów.
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace wififs {
+
+// Typ MIME i czas przechowywania w cache przeglądarki (s) wg rozszerzenia; 0 = zawsze rewalidacja ETagiem
+struct MimeRule { const char* ext; const char* type; uint32_t maxAge; };
+extern const MimeRule MIME_TABLE[];
+extern const uint8_t MIME_DEFAULT; // ostatni wpis: application/octet-stream
+
+// Wiersz tabeli /files (pola PATH, SAFEPATH, SIZE) – renderowany raz na plik, więc mierzony też na hoście
+extern const char TPL_FILE_ROW[];
+
+// Indeks w MIME_TABLE dla rozszerzenia ścieżki (bez rozróżniania wielkości liter)
+uint8_t mimeIndexFor(const char* path, size_t len);
+
+// Nagłówek Range: "bytes=a-b", "bytes=a-" lub "bytes=-n". Zwraca 1 dla poprawnego zakresu,
+// -1 gdy zakres leży poza plikiem (416), 0 gdy nagłówka brak, jest niepoprawny lub nieobsługiwany (wiele zakresów).
+int parseRange(const char* h, size_t size, size_t& start, size_t& len);
+
+// Rozwija szablon z polami %KLUCZ% (A-Z i _): out.write(p, n) dla tekstu, fill(key) dla pól.
+// Pola, dla których fill zwraca false, oraz pojedyncze '%' przechodzą bez zmian.
+template <class Out, class Fill>
+void renderTemplate(const char* tpl, Out& out, Fill fill) {
+    const char* p = tpl;
+    while (*p) {
+        const char* q = strchr(p, '%');
+        if (!q) { out.write(p, strlen(p)); return; }
+        out.write(p, q - p);
+        const char* e = q + 1;
+        while ((*e >= 'A' && *e <= 'Z') || *e == '_') e++;
+        size_t klen = e - q - 1;
+        if (*e != '%' || klen == 0 || klen >= 24) { out.write(q, 1); p = q + 1; continue; }
+        char key[24]; memcpy(key, q + 1, klen); key[klen] = 0;
+        if (!fill(key)) out.write(q, klen + 2);
+        p = e + 1;
+    }
+}
+
+// CRC-32 (IEEE 802.3), liczony przyrostowo od crc = 0
+uint32_t crc32(uint32_t crc, const uint8_t* p, size_t n);
+
+// Rekord konfiguracji: nagłówek 16 B (magic, wersja formatu, długość danych, numer generacji, CRC-32)
+// i dane jako ciąg wpisów [dł. klucza u8][klucz][dł. wartości u16 LE][wartość].
+// CRC obejmuje nagłówek od pola wersji oraz dane.
+static const uint32_t CONFIG_MAGIC = 0x43534657; // "WFSC"
+static const uint16_t CONFIG_VERSION = 1;
+static const size_t CONFIG_HEADER_SIZE = 16;
+
+class ConfigWriter {
+public:
+    ConfigWriter(uint8_t* buf, size_t cap) : _buf(buf), _cap(cap), _len(CONFIG_HEADER_SIZE), _ok(cap >= CONFIG_HEADER_SIZE) {}
+    bool put(const char* key, const char* val, size_t vlen);
+    // Uzupełnia nagłówek; zwraca długość całego rekordu lub 0 przy przepełnieniu
+    size_t finish(uint32_t seq);
+    const uint8_t* payload() const { return _buf + CONFIG_HEADER_SIZE; }
+    size_t payloadLen() const { return _len - CONFIG_HEADER_SIZE; }
+private:
+    uint8_t* _buf;
+    size_t _cap;
+    size_t _len;
+    bool _ok;
+};
+
+// Sprawdza magic, wersję, długość i CRC; przy sukcesie zwraca generację i wskaźnik na dane
+bool parseConfigRecord(const uint8_t* buf, size_t len, uint32_t& seq, const uint8_t*& payload, size_t& payloadLen);
+
+// Wywołuje fn(key, keyLen, val, valLen) dla każdego wpisu; false, gdy dane są ucięte
+template <class Fn>
+bool forEachConfigEntry(const uint8_t* p, size_t n, Fn fn) {
+    size_t i = 0;
+    while (i < n) {
+        size_t klen = p[i++];
+        if (i + klen + 2 > n) return false;
+        const char* key = (const char*)p + i; i += klen;
+        size_t vlen = p[i] | (p[i+1] << 8); i += 2;
+        if (i + vlen > n) return false;
+        fn(key, klen, (const char*)p + i, vlen); i += vlen;
+    }
+    return true;
+}
+
+} // namespace wififs
@@ -1,7 +1,29 @@
 #include "WiFiFSManager.h"
+#include "WiFiFSCore.h"
+#include <algorithm>
+#include <new>
+#include <lwip/sockets.h>
 
 static const char* WIFI_CFG_PATH = "/KonfigWiFi.txt";
 static const char* AUTH_CFG_PATH = "/KonfigAuth.txt";
+static const char* const CONFIG_SLOTS[2] = { "/KonfigA.bin", "/KonfigB.bin" };
+static const char* USER_KEY_PREFIX = "user.";
+static const size_t CONFIG_MAX_SIZE = 2048;
+
+using wififs::MIME_TABLE;
+using wififs::MimeRule;
+using wififs::TPL_FILE_ROW;
+
+static const uint8_t WIFI_EV_GOT_IP = 0x01;
+static const uint8_t WIFI_EV_DISCONNECTED = 0x02;
+static const uint32_t WIFI_APPLY_DELAY_MS = 500;
+
+// Nagłówki żądania, które WebServer ma zachować
+static const char* REQUEST_HEADERS[] = { "If-None-Match", "Accept-Encoding", "Content-Range", "Range", "If-Range", "Content-Length" };
+
+// Pliki tymczasowe uploadu leżą obok docelowych i nie trafiają do indeksu
+static const char* UPLOAD_TMP_SUFFIX = ".part";
+static const char* PUT_URI_PREFIX = "/api/files/";
 
 static const char* DEFAULT_STYLE_CSS =
 "html,body{margin:0;padding:0;font-family:system-ui,-apple-system,Segoe UI,Roboto,Arial,sans-serif;background:#f4f9f9;color:#203040}"
@@ -22,8 +44,187 @@ static const char* DEFAULT_STYLE_CSS =
 ".danger:hover{background:#8e0000}"
 "footer{max-width:960px;margin:0 auto 24px;padding:8px 16px;color:#5a7a8a}";
 
+// Szablony stron trzymane we flashu; pola %KLUCZ% wypełniane są w trakcie wysyłania
+static const char TPL_LAYOUT[] PROGMEM =
+"<!doctype html><html lang='pl'><head><meta charset='utf-8'><meta name='viewport' content='width=device-width,initial-scale=1'>"
+"<title>%TITLE%</title><link rel='stylesheet' href='/style.css'></head><body>"
+"<header><h1>%H1%</h1></header><nav>%NAV%</nav><main>%MAIN%</main>"
+"<footer><small>&copy; 2025 ESP32WiFiFS</small></footer></body></html>";
+
+static const char NAV_ROOT[] PROGMEM = "<a href='/'>Strona główna</a><a href='/files'>Pliki</a><a href='/wifi'>Ustawienia WiFi</a><a href='/auth'>Uwierzytelnianie</a>";
+static const char NAV_FILES[] PROGMEM = "<a href='/'>Strona główna</a><a href='/wifi'>Ustawienia WiFi</a><a href='/auth'>Uwierzytelnianie</a>";
+static const char NAV_WIFI[] PROGMEM = "<a href='/'>Strona główna</a><a href='/files'>Pliki</a><a href='/auth'>Uwierzytelnianie</a>";
+static const char NAV_AUTH[] PROGMEM = "<a href='/'>Strona główna</a><a href='/files'>Pliki</a><a href='/wifi'>Ustawienia WiFi</a>";
+
+static const char TPL_ROOT[] PROGMEM =
+"<section><h2>Status</h2><p>Tryb: %MODE%</p><p>Łącze: %LINK%</p><p>IP: %IP%</p>%NET%<p>mDNS: %MDNS%.local</p>"
+"<p>API: <a href='/api/status.json'>/api/status.json</a></p></section>";
+
+static const char TPL_FILES[] PROGMEM =
+"<section><h2>Lista plików</h2>%PAGER%<table><thead><tr><th>Ścieżka</th><th>Rozmiar</th><th>Akcje</th></tr></thead><tbody>%ROWS%</tbody></table></section>"
+"<section><h2>Wgraj plik</h2><form method='POST' action='/upload' enctype='multipart/form-data'><input type='file' name='upload'><br><button type='submit'>Wyślij</button></form>"
+"<p>Uwaga: pliki zapisywane są w katalogu głównym LittleFS.</p></section>";
+
+static const char TPL_PAGER[] PROGMEM =
+"<p>Pliki %FROM%–%TO% z %TOTAL% (zajęte: %USED%) %PREV% %NEXT%</p>";
+
+static const char TPL_WIFI[] PROGMEM =
+"<section><h2>Bieżący status</h2><p>Tryb: %MODE%</p><p>IP: %IP%</p>%NET%</section>"
+"<section><h2>Konfiguracja</h2><form method='POST' action='/wifi/save'><label>Tryb: <select name='mode'>"
+"<option value='STA' %STASEL%>STA</option><option value='AP' %APSEL%>AP</option></select></label><br>"
+"<label>SSID (STA): <input type='text' name='ssid' value='%SSID%'></label><br>"
+"<label>Hasło (STA): <input type='password' name='pass' value='%PASS%'></label><br>"
+"<label>AP SSID: <input type='text' name='apSsid' value='%APSSID%'></label><br>"
+"<label>AP Hasło: <input type='password' name='apPass' value='%APPASS%'></label><br>"
+"<button type='submit'>Zapisz i zastosuj</button></form></section>";
+
+static const char TPL_AUTH[] PROGMEM =
+"<section><h2>Bieżące dane</h2><p>Użytkownik: <strong>%USER%</strong></p></section>"
+"<section><h2>Zmień login/hasło</h2><form method='POST' action='/auth/save'><label>Nowy użytkownik: <input type='text' name='user' value='%USER%'></label><br>"
+"<label>Nowe hasło: <input type='password' name='pass' placeholder='min. 4 znaki'></label><br><button type='submit'>Zapisz</button></form>"
+"<p>Po zmianie przeglądarka może ponownie poprosić o hasło.</p></section>";
+
+// Odpowiedź wysyłana porcjami (Transfer-Encoding: chunked) przez bufor o stałym rozmiarze,
+// więc zużycie sterty nie zależy od długości strony ani liczby plików.
+class WiFiFSManager::ChunkWriter {
+public:
+    explicit ChunkWriter(MeteredWebServer& server) : _server(server) {}
+    ~ChunkWriter() { end(); }
+
+    void begin(int code, const char* type) {
+        _server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        _server.send(code, type, "");
+        _started = true;
+    }
+
+    void write(const char* p, size_t len) {
+        while (len) {
+            size_t n = min(len, CHUNK_BUF_SIZE - _len);
+            memcpy(_buf + _len, p, n); _len += n; p += n; len -= n;
+            if (_len == CHUNK_BUF_SIZE) flush();
+        }
+    }
+    void print(const char* s) { write(s, strlen(s)); }
+    void print(const String& s) { write(s.c_str(), s.length()); }
+    void print(unsigned long v) { char b[12]; int n = snprintf(b, sizeof(b), "%lu", v); write(b, n); }
+    void print(long v) { char b[12]; int n = snprintf(b, sizeof(b), "%ld", v); write(b, n); }
+
+    // Tekst użytkownika wstawiany do HTML (treść lub atrybut w apostrofach)
+    void printHtml(const char* s) {
+        for (; *s; s++) {
+            switch (*s) {
+                case '<': print("&lt;"); break;
+                case '>': print("&gt;"); break;
+                case '&': print("&amp;"); break;
+                case '\'': print("&#39;"); break;
+                case '"': print("&quot;"); break;
+                default: write(s, 1);
+            }
+        }
+    }
+    void printHtml(const String& s) { printHtml(s.c_str()); }
+
+    // Tekst wstawiany do łańcucha JSON (bez cudzysłowów)
+    void printJson(const char* s) {
+        for (; *s; s++) {
+            if (*s == '"' || *s == '\\') { write("\\", 1); write(s, 1); }
+            else if ((uint8_t)*s < 0x20) { char b[8]; snprintf(b, sizeof(b), "\\u%04x", (uint8_t)*s); print(b); }
+            else write(s, 1);
+        }
+    }
+    void printJson(const String& s) { printJson(s.c_str()); }
+
+    // Rozwija szablon; nieobsłużone pola %KLUCZ% przechodzą bez zmian
+    void render(const char* tpl, const TemplateFiller& fill) {
+        wififs::renderTemplate(tpl, *this, [&](const char* key) { return fill(*this, key); });
+    }
+
+    void flush() { if (_len) { _server.sendContent(_buf, _len); _len = 0; } }
+    void end() { if (_started) { flush(); _server.sendContent(""); _started = false; } }
+
+private:
+    MeteredWebServer& _server;
+    char _buf[CHUNK_BUF_SIZE];
+    size_t _len = 0;
+    bool _started = false;
+};
+
+// Stan jednego przesyłania: dane idą przez bufor wielkości bloku flash do <cel>.part,
+// który po zakończeniu atomowo zastępuje plik docelowy.
+struct WiFiFSManager::UploadSession {
+    String target;
+    String tmpPath;
+    File file;
+    std::unique_ptr<uint8_t[]> buf;
+    size_t bufLen = 0;
+    size_t offset = 0;   // bajty w .part sprzed tego żądania (wznowienie PUT)
+    size_t written = 0;  // bajty zapisane w tym żądaniu
+    size_t total = 0;    // rozmiar całości z Content-Range, 0 = nieznany
+    uint32_t startMs = 0;
+    int status = 0;      // kod błędu ustalony w trakcie (401, 400, 416, 500), 0 = OK
+    bool query = false;  // Content-Range: bytes */total – tylko pytanie o postęp
+
+    bool flush() {
+        if (!bufLen) return true;
+        bool ok = file && file.write(buf.get(), bufLen) == bufLen;
+        written += ok ? bufLen : 0; bufLen = 0;
+        if (!ok) status = 500;
+        return ok;
+    }
+    bool write(const uint8_t* p, size_t n) {
+        if (status) return false;
+        if (!buf) { bool ok = file && file.write(p, n) == n; written += ok ? n : 0; if (!ok) status = 500; return ok; }
+        while (n) {
+            size_t k = min(n, UPLOAD_BUF_SIZE - bufLen);
+            memcpy(buf.get() + bufLen, p, k); bufLen += k; p += k; n -= k;
+            if (bufLen == UPLOAD_BUF_SIZE && !flush()) return false;
+        }
+        return true;
+    }
+    size_t size() const { return offset + written + bufLen; }
+    void abort() { flush(); if (file) file.close(); }
+};
+
+// Wysyłka pliku w tle (tryb współbieżny). Kopia WiFiClient trzyma gniazdo otwarte po tym,
+// jak WebServer zwolni swoje połączenie; dane idą nieblokującym send() z handle().
+struct WiFiFSManager::Transfer {
+    bool active = false;
+    WiFiClient client;
+    File file;
+    size_t pos = 0;        // pozycja odczytu w pliku
+    size_t remaining = 0;  // bajty pliku jeszcze do odczytu
+    std::unique_ptr<uint8_t[]> buf;
+    size_t bufPos = 0;
+    size_t bufLen = 0;
+    uint32_t lastProgress = 0;
+    uint8_t route = 0;
+};
+
+// Dopasowuje każdy URI zaczynający się od podanego prefiksu
+class UriPrefix : public Uri {
+public:
+    explicit UriPrefix(const char* prefix) : Uri(prefix) {}
+    Uri* clone() const override { return new UriPrefix(_uri.c_str()); }
+    bool canHandle(const String& requestUri, std::vector<String>&) override { return requestUri.startsWith(_uri); }
+};
+
+static String urlDecode(const String& s){
+    String out; out.reserve(s.length());
+    for(size_t i=0;i<s.length();i++){
+        char c=s[i];
+        if(c=='%' && i+2<s.length()){ char h[3]={s[i+1],s[i+2],0}; out+=(char)strtol(h,nullptr,16); i+=2; }
+        else out+=c;
+    }
+    return out;
+}
+
+// Ścieżka docelowa zapisu lub zmiany nazwy: bez wyjścia poza katalog główny, nie katalog i nie plik tymczasowy uploadu
+static bool validTargetPath(const String& p){
+    return p.length()>=2 && p[0]=='/' && !p.endsWith("/") && p.indexOf("/../")<0 && !p.endsWith("/..") && !p.endsWith(UPLOAD_TMP_SUFFIX);
+}
+
 WiFiFSManager::WiFiFSManager(uint16_t port, bool debug)
-: _server(port), _debug(debug) {
+: _server(port), _debug(debug), _etagGen(esp_random()) {
     _cfg.mode = "AP";
     _cfg.apSsid = "ESP32_AP";
     _cfg.apPass = "12345678";
@@ -31,12 +232,23 @@ WiFiFSManager::WiFiFSManager(uint16_t port, bool debug)
     _fileAuthPass = "files123";
 }
 
+WiFiFSManager::~WiFiFSManager() {}
+
 bool WiFiFSManager::begin(const char* defaultApSsid, const char* defaultApPass, const char* mdnsHostname, bool formatIfFail) {
     _mdnsHostname = mdnsHostname;
     if (!mountFS(formatIfFail)) return false;
     ensureDefaultWebFiles();
-    readWiFiConfig();
-    readAuthConfig();
+    if (!loadConfig()) {
+        // Pierwsze uruchomienie po aktualizacji: import plików tekstowych do rekordu binarnego
+        bool wifiTxt = readWiFiConfig();
+        bool authTxt = readAuthConfig();
+        if (saveConfig() && (wifiTxt || authTxt)) {
+            if (wifiTxt) fsRemove(WIFI_CFG_PATH);
+            if (authTxt) fsRemove(AUTH_CFG_PATH);
+            if (_debug) Serial.println(F("[WiFiFS] przeniesiono konfigurację z plików .txt"));
+        }
+    }
+    rebuildIndex(true); // .part sprzed restartu nie zostaną już wznowione
     bool okWiFi = startWiFiFromConfig(defaultApSsid, defaultApPass);
 
     if (MDNS.begin(_mdnsHostname.c_str())) {
@@ -51,7 +263,21 @@ bool WiFiFSManager::begin(const char* defaultApSsid, const char* defaultApPass,
     return okWiFi;
 }
 
-void WiFiFSManager::handle() { _server.handleClient(); }
+void WiFiFSManager::handle() {
+    if (_indexDirty || _rescanPending) applyIndexChanges();
+    _server.handleClient();
+    // Zmiana trybu po /wifi/save dopiero gdy przekierowanie zdążyło wyjść do przeglądarki
+    if (_applyPending && millis() - _applyAt >= WIFI_APPLY_DELAY_MS) { _applyPending = false; applyWiFiConfig(); }
+    updateLink();
+    pumpTransfers();
+}
+
+void WiFiFSManager::setConcurrentMode(bool enable, uint8_t maxTransfers) {
+    _concurrent = enable && maxTransfers > 0;
+    _maxTransfers = maxTransfers;
+    while (_transfers.size() < maxTransfers) _transfers.emplace_back(new Transfer());
+    if (_debug) Serial.printf("[WiFiFS] tryb współbieżny: %s (max %u transferów)\n", _concurrent ? "ON" : "OFF", (unsigned)maxTransfers);
+}
 
 bool WiFiFSManager::mountFS(bool formatIfFail) {
     if (!LittleFS.begin(formatIfFail)) { if (_debug) Serial.println(F("[WiFiFS] LittleFS mount FAILED")); return false; }
@@ -60,16 +286,16 @@ bool WiFiFSManager::mountFS(bool formatIfFail) {
 }
 
 void WiFiFSManager::ensureDefaultWebFiles() {
-    if (!LittleFS.exists("/style.css")) {
-        File f = LittleFS.open("/style.css", "w");
+    if (!fsExists("/style.css")) {
+        File f = fsOpen("/style.css", "w");
         if (f) { f.write((const uint8_t*)DEFAULT_STYLE_CSS, strlen(DEFAULT_STYLE_CSS)); f.close(); }
         if (_debug) Serial.println(F("[WiFiFS] zapisano domyślny /style.css"));
     }
 }
 
 bool WiFiFSManager::readWiFiConfig() {
-    if (!LittleFS.exists(WIFI_CFG_PATH)) return false;
-    File f = LittleFS.open(WIFI_CFG_PATH, "r"); if (!f) return false;
+    if (!fsExists(WIFI_CFG_PATH)) return false;
+    File f = fsOpen(WIFI_CFG_PATH, "r"); if (!f) return false;
     while (f.available()) {
         String line = f.readStringUntil('\n'); line.trim();
         if (line.length()==0 || line.startsWith("#")) continue;
@@ -81,109 +307,583 @@ bool WiFiFSManager::readWiFiConfig() {
     f.close(); if (_debug) Serial.println(F("[WiFiFS] wczytano KonfigWiFi.txt")); return true;
 }
 
-bool WiFiFSManager::writeWiFiConfig() {
-    File f = LittleFS.open(WIFI_CFG_PATH, "w"); if (!f) return false;
-    f.printf("mode=%s\nssid=%s\npass=%s\napSsid=%s\napPass=%s\n", _cfg.mode.c_str(), _cfg.ssid.c_str(), _cfg.pass.c_str(), _cfg.apSsid.c_str(), _cfg.apPass.c_str());
-    f.close(); if (_debug) Serial.println(F("[WiFiFS] zapisano KonfigWiFi.txt")); return true;
-}
-
 bool WiFiFSManager::readAuthConfig() {
-    if (!LittleFS.exists(AUTH_CFG_PATH)) return false; File f=LittleFS.open(AUTH_CFG_PATH,"r"); if(!f) return false;
+    if (!fsExists(AUTH_CFG_PATH)) return false;
+    File f=fsOpen(AUTH_CFG_PATH,"r"); if(!f) return false;
     while (f.available()) { String line=f.readStringUntil('\n'); line.trim(); if(line.length()==0||line.startsWith("#")) continue; int eq=line.indexOf('='); if(eq<=0) continue; String k=line.substring(0,eq); String v=line.substring(eq+1); v.trim(); if(k=="user") _fileAuthUser=v; else if(k=="pass") _fileAuthPass=v; }
-    f.close(); if (_debug) Serial.println(F("[WiFiFS] wczytano KonfigAuth.txt")); return true;
+    f.close(); if (_debug) Serial.println(F("[WiFiFS] wczytano KonfigAuth.txt"));
+    return true;
 }
 
-bool WiFiFSManager::writeAuthConfig() {
-    File f = LittleFS.open(AUTH_CFG_PATH, "w"); if(!f) return false;
-    f.printf("user=%s\npass=%s\n", _fileAuthUser.c_str(), _fileAuthPass.c_str());
-    f.close(); if (_debug) Serial.println(F("[WiFiFS] zapisano KonfigAuth.txt")); return true;
+// Pola konfiguracji zapisywane w rekordzie binarnym; klucze użytkownika mają prefiks USER_KEY_PREFIX
+static const char* const CONFIG_KEYS[] = { "wifi.mode", "wifi.ssid", "wifi.pass", "wifi.apSsid", "wifi.apPass", "auth.user", "auth.pass" };
+
+String* WiFiFSManager::configField(const char* key){
+    if(!strcmp(key,"wifi.mode")) return &_cfg.mode;
+    if(!strcmp(key,"wifi.ssid")) return &_cfg.ssid;
+    if(!strcmp(key,"wifi.pass")) return &_cfg.pass;
+    if(!strcmp(key,"wifi.apSsid")) return &_cfg.apSsid;
+    if(!strcmp(key,"wifi.apPass")) return &_cfg.apPass;
+    if(!strcmp(key,"auth.user")) return &_fileAuthUser;
+    if(!strcmp(key,"auth.pass")) return &_fileAuthPass;
+    return nullptr;
 }
 
-String WiFiFSManager::contentTypeFor(const String& path) const {
-    if (path.endsWith(".htm")||path.endsWith(".html")) return "text/html";
-    if (path.endsWith(".css")) return "text/css";
-    if (path.endsWith(".js")) return "application/javascript";
-    if (path.endsWith(".json")) return "application/json";
-    if (path.endsWith(".txt")||path.endsWith(".csv")||path.endsWith(".ini")) return "text/plain";
-    if (path.endsWith(".png")) return "image/png";
-    if (path.endsWith(".gif")) return "image/gif";
-    if (path.endsWith(".jpg")||path.endsWith(".jpeg")) return "image/jpeg";
-    if (path.endsWith(".ico")) return "image/x-icon";
-    if (path.endsWith(".svg")) return "image/svg+xml";
-    return "application/octet-stream";
+// Wczytuje najnowszy poprawny rekord z dwóch slotów; uszkodzony (np. przerwany zapis) jest pomijany
+// Każdy slot jest czytany i sprawdzany raz: wygrywający rekord zostaje w bestBuf, kolejny slot trafia do drugiego bufora.
+bool WiFiFSManager::loadConfig(){ StateLock lock(_stateMutex);
+    std::unique_ptr<uint8_t[]> buf(new (std::nothrow) uint8_t[CONFIG_MAX_SIZE]), bestBuf(new (std::nothrow) uint8_t[CONFIG_MAX_SIZE]); if(!buf || !bestBuf) return false;
+    int best=-1; uint32_t seq=0; const uint8_t* p=nullptr; size_t plen=0;
+    for(int slot=0;slot<2;slot++){ File f=fsOpen(CONFIG_SLOTS[slot],"r"); if(!f) continue; size_t n=f.read(buf.get(), CONFIG_MAX_SIZE); f.close();
+        uint32_t s; const uint8_t* sp; size_t sl;
+        if(!wififs::parseConfigRecord(buf.get(), n, s, sp, sl)){ if(_debug) Serial.printf("[WiFiFS] %s: uszkodzony rekord, pomijam\n", CONFIG_SLOTS[slot]); continue; }
+        if(best<0 || (int32_t)(s-seq)>0){ best=slot; seq=s; p=sp; plen=sl; buf.swap(bestBuf); } }
+    if(best<0) return false;
+    size_t prefixLen=strlen(USER_KEY_PREFIX); _userCfg.clear();
+    wififs::forEachConfigEntry(p, plen, [&](const char* k, size_t kl, const char* v, size_t vl){
+        String key; key.concat(k, kl); String val; val.concat(v, vl);
+        if(key.startsWith(USER_KEY_PREFIX)) _userCfg.push_back({key.substring(prefixLen), val});
+        else if(String* field=configField(key.c_str())) *field=val; });
+    _cfgSeq=seq; _cfgSlot=best; _cfgPayloadCrc=wififs::crc32(0, p, plen); _cfgPayloadLen=plen; _cfgValid=true;
+    if(_debug) Serial.printf("[WiFiFS] wczytano konfigurację (gen %u, %s)\n", (unsigned)seq, CONFIG_SLOTS[best]);
+    return true;
 }
 
+// Zapisuje rekord do drugiego slotu tylko wtedy, gdy zawartość różni się od zatwierdzonej.
+// Stary slot zostaje nienaruszony, więc przerwany zapis nie psuje konfiguracji.
+bool WiFiFSManager::saveConfig(){ StateLock lock(_stateMutex);
+    std::unique_ptr<uint8_t[]> buf(new (std::nothrow) uint8_t[CONFIG_MAX_SIZE]); if(!buf) return false;
+    wififs::ConfigWriter w(buf.get(), CONFIG_MAX_SIZE);
+    for(const char* k : CONFIG_KEYS){ const String* v=configField(k); w.put(k, v->c_str(), v->length()); }
+    for(const UserValue& u : _userCfg){ String k=String(USER_KEY_PREFIX)+u.key; w.put(k.c_str(), u.value.c_str(), u.value.length()); }
+    size_t len=w.finish(_cfgSeq+1); if(!len){ if(_debug) Serial.println(F("[WiFiFS] konfiguracja za duża")); return false; }
+    uint32_t crc=wififs::crc32(0, w.payload(), w.payloadLen());
+    if(_cfgValid && crc==_cfgPayloadCrc && w.payloadLen()==_cfgPayloadLen) return true;
+    uint8_t slot=_cfgSlot^1; File f=fsOpen(CONFIG_SLOTS[slot],"w"); if(!f) return false;
+    bool ok=f.write(buf.get(), len)==len; f.close(); if(!ok) return false;
+    notifyFileChanged(CONFIG_SLOTS[slot]); // saveConfig bywa wołane z innych zadań (setWiFiSTA, setUserValue…)
+    _cfgSeq++; _cfgSlot=slot; _cfgPayloadCrc=crc; _cfgPayloadLen=w.payloadLen(); _cfgValid=true;
+    if(_debug) Serial.printf("[WiFiFS] zapisano konfigurację (gen %u, %s)\n", (unsigned)_cfgSeq, CONFIG_SLOTS[slot]);
+    return true;
+}
+
+// Nieudany zapis (rekord ponad CONFIG_MAX_SIZE, klucz ponad 255 B, błąd flash) cofa zmianę, żeby pamięć zgadzała się z flash
+bool WiFiFSManager::setUserValue(const String& key, const String& value){ StateLock lock(_stateMutex);
+    for(UserValue& u : _userCfg) if(u.key==key){ if(u.value==value) return true; String old=u.value; u.value=value; if(saveConfig()) return true; u.value=old; return false; }
+    _userCfg.push_back({key, value}); if(saveConfig()) return true; _userCfg.pop_back(); return false;
+}
+
+String WiFiFSManager::getUserValue(const String& key, const String& def) const { StateLock lock(_stateMutex);
+    for(const UserValue& u : _userCfg) if(u.key==key) return u.value;
+    return def;
+}
+
+uint8_t WiFiFSManager::mimeIndexFor(const String& path) const { return wififs::mimeIndexFor(path.c_str(), path.length()); }
+
+const char* WiFiFSManager::contentTypeFor(const String& path) const { return MIME_TABLE[mimeIndexFor(path)].type; }
+
 String WiFiFSManager::humanSize(size_t bytes) const { const char* u[]={"B","KB","MB"}; double v=bytes; int i=0; while(v>=1024.0 && i<2){v/=1024.0;i++;} char b[32]; snprintf(b,sizeof(b),"%.2f %s",v,u[i]); return String(b);} 
 
-size_t WiFiFSManager::calcUsedBytes(){ size_t used=0; File root=LittleFS.open("/","r"); File f=root.openNextFile(); while(f){used+=f.size(); f=root.openNextFile();} return used; }
+void WiFiFSManager::rescanIndex(){ _rescanPending=true; }
 
-bool WiFiFSManager::startWiFiFromConfig(const char* defaultApSsid, const char* defaultApPass){ if(_cfg.apSsid.length()==0) _cfg.apSsid=defaultApSsid; if(_cfg.apPass.length()==0) _cfg.apPass=defaultApPass; if(_cfg.mode=="STA" && _cfg.ssid.length()>0) return connectSTA(_cfg.ssid,_cfg.pass); else return startAP(_cfg.apSsid,_cfg.apPass);} 
+// Pliki .part nie trafiają do indeksu, ale zajmują miejsce: są liczone w _usedBytes albo (dropParts) usuwane
+void WiFiFSManager::rebuildIndex(bool dropParts){
+    { StateLock lock(_stateMutex); _indexPending.clear(); _indexDirty=false; } // pełny skan obejmuje zgłoszone zmiany
+    std::vector<String> parts; _index.clear(); _usedBytes=0; indexDir("/", dropParts ? &parts : nullptr);
+    std::sort(_index.begin(), _index.end(), [](const FileEntry& a, const FileEntry& b){ return a.path < b.path; });
+    for(const String& p : parts){ bool ok=fsRemove(p); if(_debug) Serial.printf("[WiFiFS] usuwanie porzuconego %s: %s\n", p.c_str(), ok?"OK":"FAILED"); }
+    if(_debug) Serial.printf("[WiFiFS] indeks: %u plików, %u B\n", (unsigned)_index.size(), (unsigned)_usedBytes);
+}
 
-bool WiFiFSManager::connectSTA(const String& ssid, const String& pass){ WiFi.mode(WIFI_STA); WiFi.begin(ssid.c_str(), pass.c_str()); if(_debug) Serial.printf("[WiFiFS] Łączenie z SSID \"%s\"...\n", ssid.c_str()); unsigned long t=millis(); while(WiFi.status()!=WL_CONNECTED && millis()-t<15000){ delay(250); if(_debug) Serial.print("."); } Serial.println(); if(WiFi.status()==WL_CONNECTED){ if(_debug) Serial.printf("[WiFiFS] Połączono. IP: %s\n", WiFi.localIP().toString().c_str()); _cfg.mode="STA"; writeWiFiConfig(); return true; } else { if(_debug) Serial.println(F("[WiFiFS] Nie udało się połączyć. AP.")); return startAP(_cfg.apSsid,_cfg.apPass);} }
+// Usuwanie w trakcie przeglądania katalogu LittleFS gubi wpisy, więc .part do usunięcia trafiają do parts
+void WiFiFSManager::indexDir(const String& dirPath, std::vector<String>* parts){
+    File dir=fsOpen(dirPath,"r"); if(!dir || !dir.isDirectory()) return;
+    File f=dir.openNextFile();
+    while(f){ String path=f.path();
+        if(f.isDirectory()){ f.close(); indexDir(path, parts); }
+        else if(path.endsWith(UPLOAD_TMP_SUFFIX)){ size_t size=f.size(); f.close(); if(parts) parts->push_back(path); else _usedBytes+=size; }
+        else { size_t size=f.size(); uint32_t mtime=f.getLastWrite(); f.close(); _index.push_back({path, (uint32_t)size, mtime, _etagGen++, mimeIndexFor(path)}); _usedBytes+=size; }
+        f=dir.openNextFile(); }
+}
 
-bool WiFiFSManager::startAP(const String& ssid, const String& pass){ WiFi.mode(WIFI_AP); bool ok=WiFi.softAP(ssid.c_str(), pass.c_str()); delay(100); if(_debug){ Serial.printf("[WiFiFS] AP %s: %s\n", ssid.c_str(), ok?"OK":"FAILED"); Serial.printf("[WiFiFS] AP IP: %s\n", WiFi.softAPIP().toString().c_str()); } _cfg.mode="AP"; writeWiFiConfig(); return ok; }
+size_t WiFiFSManager::indexLowerBound(const String& path) const {
+    return std::lower_bound(_index.begin(), _index.end(), path, [](const FileEntry& e, const String& p){ return e.path < p; }) - _index.begin();
+}
 
-void WiFiFSManager::setupRoutes(){
-    _server.on("/", HTTP_GET, std::bind(&WiFiFSManager::handleRoot, this));
-    _server.on("/files", HTTP_GET, std::bind(&WiFiFSManager::handleFilesPage, this));
-    _server.on("/wifi", HTTP_GET, std::bind(&WiFiFSManager::handleWiFiPage, this));
-    _server.on("/auth", HTTP_GET, std::bind(&WiFiFSManager::handleAuthPage, this));
+WiFiFSManager::FileEntry* WiFiFSManager::indexFind(const String& path){
+    size_t i=indexLowerBound(path); return (i<_index.size() && _index[i].path==path) ? &_index[i] : nullptr;
+}
 
-    _server.on("/api/files", HTTP_GET, std::bind(&WiFiFSManager::handleFileList, this));
-    _server.on("/api/files.json", HTTP_GET, std::bind(&WiFiFSManager::handleFileListJson, this));
-    _server.on("/api/status.json", HTTP_GET, std::bind(&WiFiFSManager::handleStatusJson, this));
+WiFiFSManager::FileEntry* WiFiFSManager::indexLookup(const String& path){
+    if(FileEntry* e=indexFind(path)) return e;
+    if(!path.startsWith("/") || path.endsWith(UPLOAD_TMP_SUFFIX) || !fsExists(path)) return nullptr;
+    File f=fsOpen(path,"r"); if(!f) return nullptr; if(f.isDirectory()){ f.close(); return nullptr; }
+    size_t size=f.size(); uint32_t mtime=f.getLastWrite(); f.close(); indexUpdate(path, size, mtime);
+    if(_debug) Serial.printf("[WiFiFS] indeks: dopisano %s\n", path.c_str());
+    return indexFind(path);
+}
 
-    _server.on("/view", HTTP_GET, std::bind(&WiFiFSManager::handleFileView, this));
-    _server.on("/delete", HTTP_POST, std::bind(&WiFiFSManager::handleFileDelete, this));
-    _server.on("/upload", HTTP_POST, [](){}, std::bind(&WiFiFSManager::handleFileUpload, this));
+void WiFiFSManager::notifyFileChanged(const String& path){
+    String p=path.startsWith("/") ? path : "/"+path; if(p.endsWith(UPLOAD_TMP_SUFFIX)) return;
+    StateLock lock(_stateMutex); for(const String& q : _indexPending) if(q==p) return;
+    _indexPending.push_back(p); _indexDirty=true;
+}
 
-    _server.on("/wifi/save", HTTP_POST, std::bind(&WiFiFSManager::handleWiFiSave, this));
-    _server.on("/auth/save", HTTP_POST, std::bind(&WiFiFSManager::handleAuthSave, this));
+// Zmiany zgłoszone przez notifyFileChanged()/rescanIndex(), stosowane w handle() przed obsługą klienta
+void WiFiFSManager::applyIndexChanges(){
+    if(_rescanPending.exchange(false)){ rebuildIndex(false); return; }
+    std::vector<String> paths; { StateLock lock(_stateMutex); paths.swap(_indexPending); _indexDirty=false; }
+    for(const String& p : paths) refreshEntry(p);
+}
 
-    _server.onNotFound(std::bind(&WiFiFSManager::handleStaticOr404, this));
+void WiFiFSManager::refreshEntry(const String& path){
+    File f=fsExists(path) ? fsOpen(path,"r") : File();
+    if(f && f.isDirectory()){ f.close(); rebuildIndex(false); return; }
+    if(!f){ indexRemove(path); return; }
+    size_t size=f.size(); uint32_t mtime=f.getLastWrite(); f.close(); indexUpdate(path, size, mtime);
 }
 
-bool WiFiFSManager::ensureFileAuth(){ if(_fileAuthUser.length()==0) _fileAuthUser="files"; if(_fileAuthPass.length()==0) _fileAuthPass="files123"; return true; }
+void WiFiFSManager::indexUpdate(const String& path, size_t size, uint32_t mtime){
+    size_t i=indexLowerBound(path);
+    if(i<_index.size() && _index[i].path==path){ FileEntry& e=_index[i]; _usedBytes=_usedBytes-e.size+size; e.size=size; e.mtime=mtime; e.gen=_etagGen++; return; }
+    _index.insert(_index.begin()+i, FileEntry{path, (uint32_t)size, mtime, _etagGen++, mimeIndexFor(path)}); _usedBytes+=size;
+}
 
-bool WiFiFSManager::requireFileAuth(){ ensureFileAuth(); if(!_server.authenticate(_fileAuthUser.c_str(), _fileAuthPass.c_str())){ _server.requestAuthentication(BASIC_AUTH, "ESP32WiFiFS"); return false; } return true; }
+void WiFiFSManager::indexRemove(const String& path){
+    size_t i=indexLowerBound(path);
+    if(i<_index.size() && _index[i].path==path){ _usedBytes-=_index[i].size; _index.erase(_index.begin()+i); }
+}
 
-void WiFiFSManager::handleRoot(){ String h="<!doctype html><html lang='pl'><head><meta charset='utf-8'><meta name='viewport' content='width=device-width,initial-scale=1'><title>ESP32 – WiFi & LittleFS</title><link rel='stylesheet' href='/style.css'></head><body>"; h+="<header><h1>ESP32 – WiFi & LittleFS</h1></header>"; h+="<nav><a href='/'>Strona główna</a><a href='/files'>Pliki</a><a href='/wifi'>Ustawienia WiFi</a><a href='/auth'>Uwierzytelnianie</a></nav>"; h+="<main><section><h2>Status</h2>"; h+="<p>Tryb: "+_cfg.mode+"</p><p>IP: "+ipString()+"</p>"; if(_cfg.mode=="STA"){ h+="<p>SSID: "+_cfg.ssid+"</p>"; h+=String("<p>RSSI: ")+String(WiFi.RSSI())+String(" dBm</p>"); } else { h+="<p>AP SSID: "+_cfg.apSsid+"</p>"; } h+=String("<p>mDNS: ")+_mdnsHostname+String(".local</p>"); h+="<p>API: <a href='/api/status.json'>/api/status.json</a></p>"; h+="</section></main><footer><small>&copy; 2025 ESP32WiFiFS</small></footer></body></html>"; _server.send(200, "text/html", h);} 
+void WiFiFSManager::indexRename(const String& from, const String& to){
+    const FileEntry* e=indexFind(from); if(!e) return; size_t size=e->size; uint32_t mtime=e->mtime; indexRemove(from); indexUpdate(to, size, mtime);
+}
+
+std::vector<uint32_t> WiFiFSManager::indexOrder(const String& sort, bool desc) const {
+    if(sort!="size" && !desc) return {}; // indeks jest już posortowany wg nazwy
+    std::vector<uint32_t> order(_index.size());
+    for(size_t i=0;i<order.size();i++) order[i]=desc ? order.size()-1-i : i;
+    if(sort=="size") std::stable_sort(order.begin(), order.end(), [this, desc](uint32_t a, uint32_t b){ return desc ? _index[a].size>_index[b].size : _index[a].size<_index[b].size; });
+    return order;
+}
+
+bool WiFiFSManager::startWiFiFromConfig(const char* defaultApSsid, const char* defaultApPass){ StateLock lock(_stateMutex); if(_cfg.apSsid.length()==0) _cfg.apSsid=defaultApSsid; if(_cfg.apPass.length()==0) _cfg.apPass=defaultApPass;
+    WiFi.setAutoReconnect(false); // ponowienia prowadzi updateLink()
+    WiFi.onEvent([this](WiFiEvent_t event, WiFiEventInfo_t){
+        if(event==ARDUINO_EVENT_WIFI_STA_GOT_IP) _wifiEvents.fetch_or(WIFI_EV_GOT_IP);
+        else if(event==ARDUINO_EVENT_WIFI_STA_DISCONNECTED) _wifiEvents.fetch_or(WIFI_EV_DISCONNECTED); });
+    return applyWiFiConfig(); }
+
+// W trybie AP zwraca wynik softAP(); łączenie STA jest asynchroniczne, więc tu zawsze true
+bool WiFiFSManager::applyWiFiConfig(){ StateLock lock(_stateMutex); if(_cfg.mode=="STA" && _cfg.ssid.length()>0) return connectSTA(); return startAP(_cfg.apSsid,_cfg.apPass); }
+
+// Start łączenia bez blokowania: AP działa równolegle, aż STA dostanie adres IP
+bool WiFiFSManager::connectSTA(){ StateLock lock(_stateMutex); WiFi.mode(WIFI_AP_STA); WiFi.softAP(_cfg.apSsid.c_str(), _cfg.apPass.c_str()); _backoffMs=WIFI_BACKOFF_MIN_MS; _attempts=0; beginAttempt(); return true; }
+
+void WiFiFSManager::beginAttempt(){ StateLock lock(_stateMutex); _wifiEvents=0; WiFi.begin(_cfg.ssid.c_str(), _cfg.pass.c_str()); _attempts++; _attemptStart=millis(); if(_debug) Serial.printf("[WiFiFS] Łączenie z SSID \"%s\" (próba %u)...\n", _cfg.ssid.c_str(), (unsigned)_attempts); setLinkState(LinkState::Connecting); }
+
+void WiFiFSManager::setLinkState(LinkState s){ LinkState from=_linkState; if(s==from) return; uint32_t now=millis(); _linkHistory[_transitions%LINK_HISTORY]={now,from,s}; _transitions++; if(_debug) Serial.printf("[WiFiFS] łącze: %s -> %s\n", linkStateName(from), linkStateName(s)); _linkState=s; _linkSince=now; }
+
+const char* WiFiFSManager::linkStateName(LinkState s){ switch(s){ case LinkState::Connecting: return "connecting"; case LinkState::Connected: return "connected"; case LinkState::Backoff: return "backoff"; default: return "ap"; } }
+
+// Wywoływane z handle(): przejścia stanu łącza na podstawie zdarzeń WiFi, WiFi.status() i timerów
+void WiFiFSManager::updateLink(){
+    uint8_t ev=_wifiEvents.exchange(0); uint32_t now=millis();
+    switch(_linkState){
+    case LinkState::Connecting: {
+        wl_status_t st=WiFi.status();
+        if(st==WL_CONNECTED){ WiFi.mode(WIFI_STA); _backoffMs=WIFI_BACKOFF_MIN_MS; _attempts=0; setLinkState(LinkState::Connected); if(_debug) Serial.printf("[WiFiFS] Połączono. IP: %s\n", WiFi.localIP().toString().c_str()); }
+        else if(st==WL_CONNECT_FAILED || st==WL_NO_SSID_AVAIL || now-_attemptStart>=WIFI_CONNECT_TIMEOUT_MS){
+            WiFi.disconnect(); _nextAttempt=now+_backoffMs; if(_debug) Serial.printf("[WiFiFS] Nie udało się połączyć (status %d), ponowienie za %u ms. AP aktywny.\n", st, (unsigned)_backoffMs);
+            _backoffMs=(_backoffMs*2<WIFI_BACKOFF_MAX_MS) ? _backoffMs*2 : WIFI_BACKOFF_MAX_MS; setLinkState(LinkState::Backoff); }
+        break; }
+    case LinkState::Backoff: if((int32_t)(now-_nextAttempt)>=0) beginAttempt(); break;
+    case LinkState::Connected:
+        if((ev & WIFI_EV_DISCONNECTED) || WiFi.status()!=WL_CONNECTED){ _reconnects++; if(_debug) Serial.println(F("[WiFiFS] Utracono połączenie STA, ponowne łączenie")); WiFi.mode(WIFI_AP_STA); { StateLock lock(_stateMutex); WiFi.softAP(_cfg.apSsid.c_str(), _cfg.apPass.c_str()); } beginAttempt(); }
+        break;
+    default: break;
+    }
+}
+
+bool WiFiFSManager::startAP(const String& ssid, const String& pass){ WiFi.disconnect(); WiFi.mode(WIFI_AP); bool ok=WiFi.softAP(ssid.c_str(), pass.c_str()); delay(100); if(_debug){ Serial.printf("[WiFiFS] AP %s: %s\n", ssid.c_str(), ok?"OK":"FAILED"); Serial.printf("[WiFiFS] AP IP: %s\n", WiFi.softAPIP().toString().c_str()); } setLinkState(LinkState::AP); { StateLock lock(_stateMutex); _cfg.mode="AP"; saveConfig(); } return ok; }
+
+void WiFiFSManager::setupRoutes(){
+    _server.on("/", HTTP_GET, metered("/", std::bind(&WiFiFSManager::handleRoot, this)));
+    _server.on("/files", HTTP_GET, metered("/files", std::bind(&WiFiFSManager::handleFilesPage, this)));
+    _server.on("/wifi", HTTP_GET, metered("/wifi", std::bind(&WiFiFSManager::handleWiFiPage, this)));
+    _server.on("/auth", HTTP_GET, metered("/auth", std::bind(&WiFiFSManager::handleAuthPage, this)));
+
+    _server.on("/api/files", HTTP_GET, metered("/api/files", std::bind(&WiFiFSManager::handleFileList, this)));
+    _server.on("/api/files.json", HTTP_GET, metered("/api/files.json", std::bind(&WiFiFSManager::handleFileListJson, this)));
+    _server.on("/api/status.json", HTTP_GET, metered("/api/status.json", std::bind(&WiFiFSManager::handleStatusJson, this)));
+    _server.on("/api/metrics", HTTP_GET, metered("/api/metrics", std::bind(&WiFiFSManager::handleMetrics, this)));
+    _server.on("/api/metrics.json", HTTP_GET, metered("/api/metrics.json", std::bind(&WiFiFSManager::handleMetricsJson, this)));
+
+    _server.on("/view", HTTP_GET, metered("/view", std::bind(&WiFiFSManager::handleFileView, this)));
+    _server.on("/delete", HTTP_POST, metered("/delete", std::bind(&WiFiFSManager::handleFileDelete, this)));
+    _server.on("/rename", HTTP_POST, metered("/rename", std::bind(&WiFiFSManager::handleFileRename, this)));
+    _server.on("/upload", HTTP_POST, metered("/upload", [](){}), meteredUpload(std::bind(&WiFiFSManager::handleFileUpload, this), false));
+    _server.on(UriPrefix(PUT_URI_PREFIX), HTTP_PUT, metered("/api/files/*", std::bind(&WiFiFSManager::handleFilePutDone, this)), meteredUpload(std::bind(&WiFiFSManager::handleFilePut, this), true));
+
+    _server.on("/wifi/save", HTTP_POST, metered("/wifi/save", std::bind(&WiFiFSManager::handleWiFiSave, this)));
+    _server.on("/auth/save", HTTP_POST, metered("/auth/save", std::bind(&WiFiFSManager::handleAuthSave, this)));
+
+    _server.onNotFound(metered("static", std::bind(&WiFiFSManager::handleStaticOr404, this)));
+    _server.collectHeaders(REQUEST_HEADERS, sizeof(REQUEST_HEADERS)/sizeof(REQUEST_HEADERS[0]));
+}
+
+// Pomiar żądania liczony od pierwszego wywołania dla danego żądania (przy uploadzie – od jego startu)
+WebServer::THandlerFunction WiFiFSManager::metered(const char* route, WebServer::THandlerFunction fn){
+    uint8_t id=_metrics.addRoute(route);
+    return [this, id, fn](){ if(!_reqActive){ _reqActive=true; _reqStartUs=micros(); _server.resetResponseStats(); } _currentRoute=id; fn(); endRequest(id); };
+}
+
+WebServer::THandlerFunction WiFiFSManager::meteredUpload(WebServer::THandlerFunction fn, bool raw){
+    return [this, fn, raw](){ bool start=raw ? _server.raw().status==RAW_START : _server.upload().status==UPLOAD_FILE_START; if(start || !_reqActive){ _reqActive=true; _reqStartUs=micros(); _server.resetResponseStats(); } fn(); };
+}
+
+void WiFiFSManager::endRequest(uint8_t route){
+    uint32_t us=micros()-_reqStartUs; _reqActive=false;
+    _metrics.record(route, _server.lastStatus(), us, _server.header("Content-Length").toInt(), _server.bytesOut());
+    _metrics.sampleHeap();
+}
 
-void WiFiFSManager::handleFilesPage(){ if(!requireFileAuth()) return; String h="<!doctype html><html lang='pl'><head><meta charset='utf-8'><meta name='viewport' content='width=device-width,initial-scale=1'><title>Pliki – ESP32</title><link rel='stylesheet' href='/style.css'></head><body><header><h1>Pliki w LittleFS</h1></header><nav><a href='/'>Strona główna</a><a href='/wifi'>Ustawienia WiFi</a><a href='/auth'>Uwierzytelnianie</a></nav><main><section><h2>Lista plików</h2><table><thead><tr><th>Ścieżka</th><th>Rozmiar</th><th>Akcje</th></tr></thead><tbody>"; File root=LittleFS.open("/","r"); File f=root.openNextFile(); while(f){ String path=f.name(); size_t size=f.size(); String safePath=path; safePath.replace("+", "%2B"); h+="<tr><td><a href='/view?path="+path+"'>"+path+"</a></td><td>"+humanSize(size)+"</td><td><form method='POST' action='/delete' style='display:inline'><input type='hidden' name='path' value='"+safePath+"'><button type='submit' class='danger'>Usuń</button></form> <a href='"+path+"' download>Pobierz</a></td></tr>"; f=root.openNextFile(); } h+="</tbody></table></section><section><h2>Wgraj plik</h2><form method='POST' action='/upload' enctype='multipart/form-data'><input type='file' name='upload'><br><button type='submit'>Wyślij</button></form><p>Uwaga: pliki zapisywane są w katalogu głównym LittleFS.</p></section></main><footer><small>&copy; 2025 ESP32WiFiFS</small></footer></body></html>"; _server.send(200,"text/html",h);} 
+File WiFiFSManager::fsOpen(const String& path, const char* mode, bool create){ uint32_t t=micros(); File f=LittleFS.open(path, mode, create); _metrics.recordFs(WiFiFSMetrics::FS_OPEN, micros()-t); return f; }
 
-void WiFiFSManager::handleWiFiPage(){ String h="<!doctype html><html lang='pl'><head><meta charset='utf-8'><meta name='viewport' content='width=device-width,initial-scale=1'><title>Ustawienia WiFi – ESP32</title><link rel='stylesheet' href='/style.css'></head><body><header><h1>Ustawienia WiFi</h1></header><nav><a href='/'>Strona główna</a><a href='/files'>Pliki</a><a href='/auth'>Uwierzytelnianie</a></nav><main><section><h2>Bieżący status</h2>"; h+="<p>Tryb: "+_cfg.mode+"</p><p>IP: "+ipString()+"</p>"; if(_cfg.mode=="STA") h+="<p>SSID: "+_cfg.ssid+"</p>"; h+="</section><section><h2>Konfiguracja</h2><form method='POST' action='/wifi/save'><label>Tryb: <select name='mode'>"; h+=String("<option value='STA' ")+String(_cfg.mode=="STA"?"selected":"")+String(">STA</option>"); h+=String("<option value='AP' ")+String(_cfg.mode=="AP"?"selected":"")+String(">AP</option>"); h+="</select></label><br><label>SSID (STA): <input type='text' name='ssid' value='"+_cfg.ssid+"'></label><br><label>Hasło (STA): <input type='password' name='pass' value='"+_cfg.pass+"'></label><br><label>AP SSID: <input type='text' name='apSsid' value='"+_cfg.apSsid+"'></label><br><label>AP Hasło: <input type='password' name='apPass' value='"+_cfg.apPass+"'></label><br><button type='submit'>Zapisz i zastosuj</button></form></section></main><footer><small>&copy; 2025 ESP32WiFiFS</small></footer></body></html>"; _server.send(200, "text/html", h);} 
+bool WiFiFSManager::fsExists(const String& path){ uint32_t t=micros(); bool ok=LittleFS.exists(path); _metrics.recordFs(WiFiFSMetrics::FS_EXISTS, micros()-t); return ok; }
 
-void WiFiFSManager::handleAuthPage(){ if(!requireFileAuth()) return; String h="<!doctype html><html lang='pl'><head><meta charset='utf-8'><meta name='viewport' content='width=device-width,initial-scale=1'><title>Uwierzytelnianie – ESP32</title><link rel='stylesheet' href='/style.css'></head><body><header><h1>Uwierzytelnianie operacji na plikach</h1></header><nav><a href='/'>Strona główna</a><a href='/files'>Pliki</a><a href='/wifi'>Ustawienia WiFi</a></nav><main><section><h2>Bieżące dane</h2><p>Użytkownik: <strong>"+_fileAuthUser+"</strong></p></section><section><h2>Zmień login/hasło</h2><form method='POST' action='/auth/save'><label>Nowy użytkownik: <input type='text' name='user' value='"+_fileAuthUser+"'></label><br><label>Nowe hasło: <input type='password' name='pass' placeholder='min. 4 znaki'></label><br><button type='submit'>Zapisz</button></form><p>Po zmianie przeglądarka może ponownie poprosić o hasło.</p></section></main><footer><small>&copy; 2025 ESP32WiFiFS</small></footer></body></html>"; _server.send(200,"text/html",h);} 
+bool WiFiFSManager::fsRemove(const String& path){ uint32_t t=micros(); bool ok=LittleFS.remove(path); _metrics.recordFs(WiFiFSMetrics::FS_REMOVE, micros()-t); return ok; }
 
-void WiFiFSManager::handleAuthSave(){ if(!requireFileAuth()) return; String user=_server.arg("user"); user.trim(); String pass=_server.arg("pass"); pass.trim(); if(user.length()==0){ _server.send(400,"text/plain","Użytkownik nie może być pusty"); return;} if(pass.length()<4){ _server.send(400,"text/plain","Hasło musi mieć min. 4 znaki"); return;} _fileAuthUser=user; _fileAuthPass=pass; writeAuthConfig(); _server.sendHeader("Location","/files",true); _server.send(302,"text/plain",""); }
+bool WiFiFSManager::fsRename(const String& from, const String& to){ uint32_t t=micros(); bool ok=LittleFS.rename(from, to); _metrics.recordFs(WiFiFSMetrics::FS_RENAME, micros()-t); return ok; }
+
+bool WiFiFSManager::ensureFileAuth(){ StateLock lock(_stateMutex); if(_fileAuthUser.length()==0) _fileAuthUser="files"; if(_fileAuthPass.length()==0) _fileAuthPass="files123"; return true; }
+
+bool WiFiFSManager::checkFileAuth(){ String user, pass; { StateLock lock(_stateMutex); ensureFileAuth(); user=_fileAuthUser; pass=_fileAuthPass; } return _server.authenticate(user.c_str(), pass.c_str()); }
+
+bool WiFiFSManager::requireFileAuth(){ if(!checkFileAuth()){ _server.requestAuthentication(BASIC_AUTH, "ESP32WiFiFS"); return false; } return true; }
+
+void WiFiFSManager::sendPage(const char* title, const char* h1, const char* nav, const char* body, const TemplateFiller& fill){
+    ChunkWriter out(_server); out.begin(200, "text/html");
+    out.render(TPL_LAYOUT, [&](ChunkWriter& o, const char* key){
+        if(!strcmp(key,"TITLE")){ o.print(title); return true; }
+        if(!strcmp(key,"H1")){ o.print(h1); return true; }
+        if(!strcmp(key,"NAV")){ o.print(nav); return true; }
+        if(!strcmp(key,"MAIN")){ o.render(body, fill); return true; }
+        return false; });
+}
+
+void WiFiFSManager::handleRoot(){ WiFiConfig cfg=getConfig(); sendPage("ESP32 – WiFi & LittleFS", "ESP32 – WiFi & LittleFS", NAV_ROOT, TPL_ROOT, [this, &cfg](ChunkWriter& o, const char* key){
+        if(!strcmp(key,"MODE")) o.print(cfg.mode);
+        else if(!strcmp(key,"IP")) o.print(ipString());
+        else if(!strcmp(key,"MDNS")) o.printHtml(_mdnsHostname);
+        else if(!strcmp(key,"LINK")) o.print(linkStateName(_linkState));
+        else if(!strcmp(key,"NET")){ if(cfg.mode=="STA"){ o.print("<p>SSID: "); o.printHtml(cfg.ssid); o.print("</p><p>RSSI: "); o.print((long)WiFi.RSSI()); o.print(" dBm</p>"); } else { o.print("<p>AP SSID: "); o.printHtml(cfg.apSsid); o.print("</p>"); } }
+        else return false;
+        return true; }); }
+
+void WiFiFSManager::handleFilesPage(){ if(!requireFileAuth()) return;
+    size_t total=_index.size(); size_t pages=total ? (total+FILES_PAGE_SIZE-1)/FILES_PAGE_SIZE : 1;
+    size_t page=_server.arg("page").toInt(); if(page<1) page=1; if(page>pages) page=pages;
+    size_t from=(page-1)*FILES_PAGE_SIZE, to=min(total, from+FILES_PAGE_SIZE);
+    sendPage("Pliki – ESP32", "Pliki w LittleFS", NAV_FILES, TPL_FILES, [&](ChunkWriter& o, const char* key){
+        if(!strcmp(key,"PAGER")){ o.render(TPL_PAGER, [&](ChunkWriter& p, const char* k){
+                if(!strcmp(k,"FROM")) p.print((unsigned long)(total ? from+1 : 0));
+                else if(!strcmp(k,"TO")) p.print((unsigned long)to);
+                else if(!strcmp(k,"TOTAL")) p.print((unsigned long)total);
+                else if(!strcmp(k,"USED")) p.print(humanSize(_usedBytes));
+                else if(!strcmp(k,"PREV")){ if(page>1){ p.print("<a href='/files?page="); p.print((unsigned long)(page-1)); p.print("'>&laquo; poprzednie</a>"); } }
+                else if(!strcmp(k,"NEXT")){ if(page<pages){ p.print("<a href='/files?page="); p.print((unsigned long)(page+1)); p.print("'>następne &raquo;</a>"); } }
+                else return false;
+                return true; });
+            return true; }
+        if(strcmp(key,"ROWS")) return false;
+        for(size_t i=from;i<to;i++){ const FileEntry& e=_index[i];
+            o.render(TPL_FILE_ROW, [&](ChunkWriter& r, const char* k){
+                if(!strcmp(k,"PATH")) r.printHtml(e.path);
+                else if(!strcmp(k,"SIZE")) r.print(humanSize(e.size));
+                else if(!strcmp(k,"SAFEPATH")){ String safePath=e.path; safePath.replace("+", "%2B"); r.printHtml(safePath); }
+                else return false;
+                return true; }); }
+        return true; }); }
+
+void WiFiFSManager::handleWiFiPage(){ WiFiConfig cfg=getConfig(); sendPage("Ustawienia WiFi – ESP32", "Ustawienia WiFi", NAV_WIFI, TPL_WIFI, [this, &cfg](ChunkWriter& o, const char* key){
+        if(!strcmp(key,"MODE")) o.print(cfg.mode);
+        else if(!strcmp(key,"IP")) o.print(ipString());
+        else if(!strcmp(key,"NET")){ if(cfg.mode=="STA"){ o.print("<p>SSID: "); o.printHtml(cfg.ssid); o.print("</p>"); } }
+        else if(!strcmp(key,"STASEL")) o.print(cfg.mode=="STA"?"selected":"");
+        else if(!strcmp(key,"APSEL")) o.print(cfg.mode=="AP"?"selected":"");
+        else if(!strcmp(key,"SSID")) o.printHtml(cfg.ssid);
+        else if(!strcmp(key,"PASS")) o.printHtml(cfg.pass);
+        else if(!strcmp(key,"APSSID")) o.printHtml(cfg.apSsid);
+        else if(!strcmp(key,"APPASS")) o.printHtml(cfg.apPass);
+        else return false;
+        return true; }); }
+
+void WiFiFSManager::handleAuthPage(){ if(!requireFileAuth()) return; sendPage("Uwierzytelnianie – ESP32", "Uwierzytelnianie operacji na plikach", NAV_AUTH, TPL_AUTH, [this](ChunkWriter& o, const char* key){
+        if(strcmp(key,"USER")) return false;
+        String user; { StateLock lock(_stateMutex); user=_fileAuthUser; } o.printHtml(user); return true; }); }
+
+void WiFiFSManager::handleAuthSave(){ if(!requireFileAuth()) return; String user=_server.arg("user"); user.trim(); String pass=_server.arg("pass"); pass.trim(); if(user.length()==0){ _server.send(400,"text/plain","Użytkownik nie może być pusty"); return;} if(pass.length()<4){ _server.send(400,"text/plain","Hasło musi mieć min. 4 znaki"); return;} { StateLock lock(_stateMutex); _fileAuthUser=user; _fileAuthPass=pass; saveConfig(); } _server.sendHeader("Location","/files",true); _server.send(302,"text/plain",""); }
 
 void WiFiFSManager::handleFileList(){ if(!requireFileAuth()) return; handleFilesPage(); }
 
-void WiFiFSManager::handleFileListJson(){ if(!requireFileAuth()) return; String j="{\"files\":["; bool first = true; File root=LittleFS.open("/","r"); File f=root.openNextFile();
-    while(f){ if(!first) j+=","; first = false; j+="{\"path\":\""+String(f.name())+"\",\"size\":"+String((unsigned long)f.size())+"}"; f=root.openNextFile(); }
-    j+="],\"usedBytes\":"+String((unsigned long)calcUsedBytes())+"}"; _server.send(200,"application/json",j);} 
+// /api/files.json?offset=&limit=&sort=name|size&order=asc|desc
+void WiFiFSManager::handleFileListJson(){ if(!requireFileAuth()) return;
+    size_t total=_index.size(); size_t offset=_server.arg("offset").toInt(); if(offset>total) offset=total;
+    size_t limit=_server.hasArg("limit") ? (size_t)_server.arg("limit").toInt() : total; if(limit>total) limit=total; size_t end=min(total, offset+limit);
+    std::vector<uint32_t> order=indexOrder(_server.arg("sort"), _server.arg("order")=="desc");
+    ChunkWriter out(_server); out.begin(200,"application/json"); out.print("{\"files\":[");
+    for(size_t i=offset;i<end;i++){ const FileEntry& e=_index[order.empty() ? i : order[i]]; if(i>offset) out.print(",");
+        out.print("{\"path\":\""); out.printJson(e.path); out.print("\",\"size\":"); out.print((unsigned long)e.size); out.print(",\"type\":\""); out.print(MIME_TABLE[e.mime].type); out.print("\"}"); }
+    out.print("],\"total\":"); out.print((unsigned long)total); out.print(",\"offset\":"); out.print((unsigned long)offset);
+    out.print(",\"usedBytes\":"); out.print((unsigned long)_usedBytes); out.print("}"); }
+
+void WiFiFSManager::handleStatusJson(){ WiFiConfig cfg=getConfig(); uint32_t now=millis(); String j="{"; j+="\"mode\":\""+cfg.mode+"\","; j+="\"ip\":\""+ipString()+"\","; if(cfg.mode=="STA"){ j+="\"ssid\":\""+cfg.ssid+"\","; j+="\"rssi\":"+String(WiFi.RSSI())+","; } else { j+="\"apSsid\":\""+cfg.apSsid+"\","; }
+    j+="\"link\":\""+String(linkStateName(_linkState))+"\",\"linkAgeMs\":"+String((unsigned long)(now-_linkSince))+",\"attempts\":"+String((unsigned long)_attempts)+",\"reconnects\":"+String((unsigned long)_reconnects)+",";
+    if(_linkState==LinkState::Backoff) j+="\"nextRetryMs\":"+String((unsigned long)((int32_t)(_nextAttempt-now)>0 ? _nextAttempt-now : 0))+",";
+    j+="\"transitions\":"+String((unsigned long)_transitions)+",\"history\":["; size_t n=(_transitions<LINK_HISTORY) ? _transitions : LINK_HISTORY;
+    for(size_t i=0;i<n;i++){ const LinkTransition& t=_linkHistory[(_transitions-n+i)%LINK_HISTORY]; if(i) j+=","; j+="{\"agoMs\":"+String((unsigned long)(now-t.at))+",\"from\":\""+linkStateName(t.from)+"\",\"to\":\""+linkStateName(t.to)+"\"}"; }
+    j+="],\"mdns\":\""+_mdnsHostname+".local\"}"; _server.send(200,"application/json",j);} 
+
+// Format tekstowy Prometheusa (text/plain; version=0.0.4)
+void WiFiFSManager::handleMetrics(){
+    ChunkWriter out(_server); out.begin(200, "text/plain; version=0.0.4; charset=utf-8");
+    auto secs=[&](uint32_t v, uint32_t div){ char b[24]; snprintf(b,sizeof(b),"%lu.%06lu",(unsigned long)(v/div),(unsigned long)((uint64_t)(v%div)*1000000/div)); out.print(b); };
+    static const char* STATUS_CLASS[]={"other","1xx","2xx","3xx","4xx","5xx"};
+    out.print("# TYPE wififs_http_requests_total counter\n");
+    for(size_t i=0;i<_metrics.routeCount();i++){ const WiFiFSMetrics::Route& r=_metrics.route(i);
+        for(size_t c=0;c<6;c++){ uint32_t n=r.status[c]; if(!n) continue; out.print("wififs_http_requests_total{route=\""); out.print(r.name); out.print("\",code=\""); out.print(STATUS_CLASS[c]); out.print("\"} "); out.print((unsigned long)n); out.print("\n"); } }
+    out.print("# TYPE wififs_http_request_duration_seconds histogram\n");
+    for(size_t i=0;i<_metrics.routeCount();i++){ const WiFiFSMetrics::Route& r=_metrics.route(i); uint32_t cum=0;
+        for(size_t b=0;b<=WiFiFSMetrics::LATENCY_BUCKETS;b++){ cum+=r.latency[b];
+            out.print("wififs_http_request_duration_seconds_bucket{route=\""); out.print(r.name); out.print("\",le=\"");
+            if(b<WiFiFSMetrics::LATENCY_BUCKETS) secs(WiFiFSMetrics::LATENCY_BOUNDS_MS[b],1000); else out.print("+Inf");
+            out.print("\"} "); out.print((unsigned long)cum); out.print("\n"); }
+        out.print("wififs_http_request_duration_seconds_sum{route=\""); out.print(r.name); out.print("\"} "); secs(r.latencySumMs,1000); out.print("\n");
+        out.print("wififs_http_request_duration_seconds_count{route=\""); out.print(r.name); out.print("\"} "); out.print((unsigned long)r.count.load()); out.print("\n"); }
+    out.print("# TYPE wififs_http_bytes_total counter\n");
+    for(size_t i=0;i<_metrics.routeCount();i++){ const WiFiFSMetrics::Route& r=_metrics.route(i); if(!r.count) continue;
+        out.print("wififs_http_bytes_total{route=\""); out.print(r.name); out.print("\",dir=\"in\"} "); out.print((unsigned long)r.bytesIn.load()); out.print("\n");
+        out.print("wififs_http_bytes_total{route=\""); out.print(r.name); out.print("\",dir=\"out\"} "); out.print((unsigned long)r.bytesOut.load()); out.print("\n"); }
+    // Każda rodzina to jedna grupa: linia TYPE, a po niej wszystkie jej próbki
+    auto fsFamily=[&](const char* family, const char* type, uint8_t field){
+        out.print("# TYPE "); out.print(family); out.print(" "); out.print(type); out.print("\n");
+        for(uint8_t op=0;op<WiFiFSMetrics::FS_OP_COUNT;op++){ const WiFiFSMetrics::FsCounter& c=_metrics.fs((WiFiFSMetrics::FsOp)op);
+            out.print(family); out.print("{op=\""); out.print(WiFiFSMetrics::fsOpName((WiFiFSMetrics::FsOp)op)); out.print("\"} ");
+            if(field==0) out.print((unsigned long)c.count.load()); else secs(field==1 ? c.sumUs : c.maxUs, 1000000);
+            out.print("\n"); } };
+    fsFamily("wififs_fs_ops_total", "counter", 0);
+    fsFamily("wififs_fs_op_seconds_total", "counter", 1);
+    fsFamily("wififs_fs_op_max_seconds", "gauge", 2);
+    out.print("# TYPE wififs_heap_free_bytes gauge\nwififs_heap_free_bytes "); out.print((unsigned long)ESP.getFreeHeap());
+    out.print("\n# TYPE wififs_heap_min_free_bytes gauge\nwififs_heap_min_free_bytes "); out.print((unsigned long)ESP.getMinFreeHeap());
+    out.print("\n# TYPE wififs_heap_request_low_water_bytes gauge\nwififs_heap_request_low_water_bytes "); out.print((unsigned long)_metrics.heapLowWater());
+    out.print("\n# TYPE wififs_wifi_reconnects_total counter\nwififs_wifi_reconnects_total "); out.print((unsigned long)_reconnects);
+    out.print("\n# TYPE wififs_wifi_link_transitions_total counter\nwififs_wifi_link_transitions_total "); out.print((unsigned long)_transitions);
+    out.print("\n# TYPE wififs_transfers_active gauge\nwififs_transfers_active "); out.print((unsigned long)activeTransfers());
+    out.print("\n# TYPE wififs_transfers_rejected_total counter\nwififs_transfers_rejected_total "); out.print((unsigned long)_transfersRejected);
+    out.print("\n# TYPE wififs_uptime_seconds gauge\nwififs_uptime_seconds "); secs(millis(),1000); out.print("\n");
+}
+
+void WiFiFSManager::handleMetricsJson(){
+    ChunkWriter out(_server); out.begin(200, "application/json"); uint32_t now=millis();
+    out.print("{\"uptimeMs\":"); out.print((unsigned long)now);
+    out.print(",\"heap\":{\"free\":"); out.print((unsigned long)ESP.getFreeHeap()); out.print(",\"minFree\":"); out.print((unsigned long)ESP.getMinFreeHeap()); out.print(",\"requestLowWater\":"); out.print((unsigned long)_metrics.heapLowWater());
+    out.print("},\"wifi\":{\"link\":\""); out.print(linkStateName(_linkState)); out.print("\",\"reconnects\":"); out.print((unsigned long)_reconnects); out.print(",\"transitions\":"); out.print((unsigned long)_transitions);
+    out.print("},\"transfers\":{\"active\":"); out.print((unsigned long)activeTransfers()); out.print(",\"max\":"); out.print((unsigned long)_maxTransfers); out.print(",\"rejected\":"); out.print((unsigned long)_transfersRejected);
+    out.print("},\"fs\":{");
+    for(uint8_t op=0;op<WiFiFSMetrics::FS_OP_COUNT;op++){ const WiFiFSMetrics::FsCounter& c=_metrics.fs((WiFiFSMetrics::FsOp)op); if(op) out.print(",");
+        out.print("\""); out.print(WiFiFSMetrics::fsOpName((WiFiFSMetrics::FsOp)op)); out.print("\":{\"count\":"); out.print((unsigned long)c.count.load()); out.print(",\"sumUs\":"); out.print((unsigned long)c.sumUs.load()); out.print(",\"maxUs\":"); out.print((unsigned long)c.maxUs.load()); out.print("}"); }
+    out.print("},\"latencyBoundsMs\":[");
+    for(size_t b=0;b<WiFiFSMetrics::LATENCY_BUCKETS;b++){ if(b) out.print(","); out.print((unsigned long)WiFiFSMetrics::LATENCY_BOUNDS_MS[b]); }
+    out.print("],\"routes\":[");
+    for(size_t i=0;i<_metrics.routeCount();i++){ const WiFiFSMetrics::Route& r=_metrics.route(i); if(i) out.print(",");
+        out.print("{\"route\":\""); out.printJson(r.name); out.print("\",\"count\":"); out.print((unsigned long)r.count.load()); out.print(",\"status\":[");
+        for(size_t c=0;c<6;c++){ if(c) out.print(","); out.print((unsigned long)r.status[c].load()); }
+        out.print("],\"latency\":[");
+        for(size_t b=0;b<=WiFiFSMetrics::LATENCY_BUCKETS;b++){ if(b) out.print(","); out.print((unsigned long)r.latency[b].load()); }
+        out.print("],\"latencySumMs\":"); out.print((unsigned long)r.latencySumMs.load()); out.print(",\"bytesIn\":"); out.print((unsigned long)r.bytesIn.load()); out.print(",\"bytesOut\":"); out.print((unsigned long)r.bytesOut.load()); out.print("}"); }
+    out.print("],\"slowThresholdMs\":"); out.print((unsigned long)_metrics.slowThresholdMs()); out.print(",\"slow\":[");
+    WiFiFSMetrics::SlowRequest sr; for(size_t i=0;_metrics.slowRequest(i, sr);i++){ if(i) out.print(",");
+        out.print("{\"route\":\""); out.printJson(_metrics.route(sr.route).name); out.print("\",\"status\":"); out.print((unsigned long)sr.status); out.print(",\"ms\":"); out.print((unsigned long)sr.ms); out.print(",\"agoMs\":"); out.print((unsigned long)(now-sr.at)); out.print("}"); }
+    out.print("]}");
+}
+
+void WiFiFSManager::handleFileView(){ String path=_server.arg("path"); if(path.length()==0 || !serveFile(path, false)) _server.send(404,"text/html","<html><body><h3>Plik nie istnieje</h3></body></html>"); }
+
+void WiFiFSManager::handleFileDelete(){ if(!requireFileAuth()) return; String path=_server.arg("path"); path.trim(); if(path.length() && path[0]!='/') path = "/" + path; bool exists = indexLookup(path)!=nullptr; if(!exists && path.indexOf(' ')!=-1){ String alt = path; alt.replace(" ", "+"); if(indexLookup(alt)){ path = alt; exists = true; } }
+    if(!exists){ _server.send(404,"text/plain","Nie znaleziono pliku"); if(_debug) Serial.printf("[WiFiFS] delete miss: '%s'\n", path.c_str()); return; } bool ok=fsRemove(path); if(ok) indexRemove(path); if(_debug) Serial.printf("[WiFiFS] usuwanie %s: %s\n", path.c_str(), ok?"OK":"FAILED"); _server.sendHeader("Location","/files",true); _server.send(302,"text/plain",""); }
+
+void WiFiFSManager::handleFileUpload(){ if(!requireFileAuth()) return; HTTPUpload& upload=_server.upload();
+    if(upload.status==UPLOAD_FILE_START){ String filename=upload.filename; if(!filename.startsWith("/")) filename="/"+filename;
+        _upload.reset(new UploadSession()); UploadSession& u=*_upload; u.target=filename; u.tmpPath=filename+UPLOAD_TMP_SUFFIX; u.startMs=millis();
+        if(!validTargetPath(filename)){ u.status=400; return; }
+        u.buf.reset(new (std::nothrow) uint8_t[UPLOAD_BUF_SIZE]); u.file=fsOpen(u.tmpPath,"w"); if(!u.file) u.status=500;
+        if(_debug) Serial.printf("[WiFiFS] upload start: %s\n", filename.c_str()); }
+    else if(!_upload) return;
+    else if(upload.status==UPLOAD_FILE_WRITE){ _upload->write(upload.buf, upload.currentSize); }
+    else if(upload.status==UPLOAD_FILE_END){ int status=_upload->status; bool ok=status!=400 && commitUpload(*_upload); _upload.reset();
+        if(status==400){ _server.send(400,"text/plain","Nieprawidłowa nazwa pliku"); return; }
+        if(!ok){ _server.send(500,"text/plain","Zapis pliku nie powiódł się"); return; }
+        _server.sendHeader("Location","/files",true); _server.send(302,"text/plain",""); }
+    else if(upload.status==UPLOAD_FILE_ABORTED){ _upload->abort(); if(_upload->status!=400) fsRemove(_upload->tmpPath); _upload.reset(); if(_debug) Serial.println(F("[WiFiFS] upload aborted")); _server.send(500,"text/plain","Upload przerwany"); } }
+
+// Zrzuca bufor i zamyka .part, a potem podmienia plik docelowy jednym rename()
+bool WiFiFSManager::commitUpload(UploadSession& u){
+    bool ok=!u.status && u.flush(); size_t size=u.size(); if(u.file) u.file.close();
+    if(ok && u.total && size!=u.total) ok=false;
+    if(ok && !fsRename(u.tmpPath, u.target)){ fsRemove(u.target); ok=fsRename(u.tmpPath, u.target); }
+    if(!ok){ fsRemove(u.tmpPath); if(_debug) Serial.printf("[WiFiFS] upload %s: FAILED\n", u.target.c_str()); return false; }
+    indexUpdate(u.target, size);
+    if(_debug){ uint32_t ms=millis()-u.startMs; Serial.printf("[WiFiFS] upload end: %s (%u bytes, %u ms, %lu B/s)\n", u.target.c_str(), (unsigned)size, (unsigned)ms, (unsigned long)(ms ? (uint64_t)u.written*1000/ms : u.written)); }
+    return true;
+}
 
-void WiFiFSManager::handleStatusJson(){ String j="{"; j+="\"mode\":\""+_cfg.mode+"\","; j+="\"ip\":\""+ipString()+"\","; if(_cfg.mode=="STA"){ j+="\"ssid\":\""+_cfg.ssid+"\","; j+="\"rssi\":"+String(WiFi.RSSI())+","; } else { j+="\"apSsid\":\""+_cfg.apSsid+"\","; } j+="\"mdns\":\""+_mdnsHostname+".local\"}"; _server.send(200,"application/json",j);} 
+// PUT /api/files/<ścieżka> – surowe dane bez multipart; Content-Range: bytes a-b/total wznawia przerwany transfer,
+// a bytes */total pyta o liczbę już przyjętych bajtów.
+void WiFiFSManager::handleFilePut(){ HTTPRaw& raw=_server.raw();
+    if(raw.status==RAW_START){ _upload.reset(new UploadSession()); UploadSession& u=*_upload; u.startMs=millis();
+        if(!checkFileAuth()){ u.status=401; return; }
+        u.target=urlDecode(_server.uri().substring(strlen(PUT_URI_PREFIX)-1));
+        if(!validTargetPath(u.target)){ u.status=400; return; }
+        u.tmpPath=u.target+UPLOAD_TMP_SUFFIX;
+        File cur=fsOpen(u.tmpPath,"r"); size_t have=cur ? cur.size() : 0; if(cur) cur.close();
+        String cr=_server.header("Content-Range"); size_t start=0;
+        if(cr.length()){ int sp=cr.indexOf(' '), dash=cr.indexOf('-'), slash=cr.indexOf('/');
+            if(!cr.startsWith("bytes ") || slash<0){ u.status=400; return; }
+            u.total=cr.substring(slash+1).toInt();
+            if(cr.substring(sp+1,slash)=="*"){ u.query=true; u.offset=have; return; }
+            if(dash<0 || dash>slash){ u.status=400; return; }
+            start=cr.substring(sp+1,dash).toInt();
+            if(start!=0 && start!=have){ u.offset=have; u.status=416; return; } }
+        u.offset=start; u.buf.reset(new (std::nothrow) uint8_t[UPLOAD_BUF_SIZE]);
+        u.file=start ? fsOpen(u.tmpPath,"a") : fsOpen(u.tmpPath,"w",true); if(!u.file) u.status=500;
+        if(_debug) Serial.printf("[WiFiFS] PUT start: %s od %u\n", u.target.c_str(), (unsigned)start); }
+    else if(!_upload) return;
+    else if(raw.status==RAW_WRITE){ _upload->write(raw.buf, raw.currentSize); }
+    else if(raw.status==RAW_END){ UploadSession& u=*_upload; if(u.status || u.query) return;
+        if(u.total && u.size()<u.total){ u.flush(); u.file.close(); if(_debug) Serial.printf("[WiFiFS] PUT częściowy: %s (%u/%u)\n", u.target.c_str(), (unsigned)u.size(), (unsigned)u.total); return; }
+        if(!commitUpload(u)) u.status=500; }
+    else if(raw.status==RAW_ABORTED){ _upload->abort(); if(_debug) Serial.printf("[WiFiFS] PUT przerwany: %s (zachowano %u B)\n", _upload->target.c_str(), (unsigned)_upload->size()); } }
+
+void WiFiFSManager::handleFilePutDone(){
+    std::unique_ptr<UploadSession> u(std::move(_upload));
+    if(!u){ _server.send(400,"text/plain","Brak danych"); return; }
+    if(u->status==401){ _server.requestAuthentication(BASIC_AUTH, "ESP32WiFiFS"); return; }
+    if(u->status==400){ _server.send(400,"text/plain","Nieprawidłowe żądanie"); return; }
+    if(u->status==500){ _server.send(500,"text/plain","Zapis pliku nie powiódł się"); return; }
+    size_t have=u->size(); if(u->file) u->file.close();
+    if(u->status==416 || u->query || (u->total && have<u->total)){
+        if(have) _server.sendHeader("Range", String("bytes=0-")+String((unsigned long)(have-1)));
+        _server.send(u->status==416 ? 416 : 308); return; }
+    ChunkWriter out(_server); out.begin(201,"application/json"); out.print("{\"path\":\""); out.printJson(u->target); out.print("\",\"size\":"); out.print((unsigned long)have); out.print("}"); }
+
+void WiFiFSManager::handleFileRename(){ if(!requireFileAuth()) return; String from=_server.arg("from"); from.trim(); String to=_server.arg("to"); to.trim(); if(from.length() && from[0]!='/') from = "/" + from; if(to.length() && to[0]!='/') to = "/" + to;
+    if(!indexLookup(from)){ _server.send(404,"text/plain","Nie znaleziono pliku"); return; } if(!validTargetPath(to)){ _server.send(400,"text/plain","Nieprawidłowa nazwa"); return; } if(indexLookup(to)){ _server.send(409,"text/plain","Plik docelowy już istnieje"); return; }
+    bool ok=fsRename(from, to); if(ok) indexRename(from, to); if(_debug) Serial.printf("[WiFiFS] zmiana nazwy %s -> %s: %s\n", from.c_str(), to.c_str(), ok?"OK":"FAILED"); if(!ok){ _server.send(500,"text/plain","Zmiana nazwy nie powiodła się"); return; } _server.sendHeader("Location","/files",true); _server.send(302,"text/plain",""); }
+
+void WiFiFSManager::handleWiFiSave(){ String mode=_server.arg("mode"); mode.trim(); String ssid=_server.arg("ssid"); ssid.trim(); String pass=_server.arg("pass"); pass.trim(); String apSsid=_server.arg("apSsid"); apSsid.trim(); String apPass=_server.arg("apPass"); apPass.trim(); if(mode!="STA" && mode!="AP") mode="AP"; { StateLock lock(_stateMutex); _cfg.mode=mode; if(ssid.length()) _cfg.ssid=ssid; _cfg.pass=pass; if(apSsid.length()) _cfg.apSsid=apSsid; if(apPass.length()) _cfg.apPass=apPass; saveConfig(); } _applyAt=millis(); _applyPending=true; _server.sendHeader("Location","/wifi",true); _server.send(302,"text/plain",""); }
+
+// Wysyła plik z indeksu z ETagiem i Cache-Control; przy negotiateGzip wybiera wariant .gz, jeśli klient go akceptuje.
+// Zwraca false, gdy pliku nie ma (odpowiedź 404 należy do wywołującego).
+bool WiFiFSManager::serveFile(const String& path, bool negotiateGzip){
+    FileEntry* e=indexLookup(path);
+    FileEntry* gz=(negotiateGzip && !path.endsWith(".gz")) ? indexFind(path+".gz") : nullptr;
+    FileEntry* src=(gz && _server.header("Accept-Encoding").indexOf("gzip")>=0) ? gz : e;
+    if(!src) return false;
+    String etag=etagFor(*src);
+    const MimeRule& m=MIME_TABLE[mimeIndexFor(path)];
+    String cacheControl=m.maxAge ? String("public, max-age=")+String((unsigned long)m.maxAge) : String("no-cache");
+    auto validators=[&](){ _server.sendHeader("ETag", etag); _server.sendHeader("Cache-Control", cacheControl); _server.sendHeader("Accept-Ranges", "bytes"); if(gz) _server.sendHeader("Vary","Accept-Encoding"); };
+    // 304 prosto z indeksu, bez otwierania pliku; zmiany spoza panelu zgłasza notifyFileChanged()
+    String inm=_server.header("If-None-Match");
+    if(inm.length() && (inm=="*" || inm.indexOf(etag)>=0)){ validators(); _server.send(304); return true; }
+    File f=fsOpen(src->path,"r"); if(!f){ String stale=src->path; indexRemove(stale); return false; }
+    // Plik zmieniony poza panelem bez zgłoszenia – nowa wersja wpisu, więc i nowy ETag (If-Range go już nie dopasuje)
+    uint32_t mtime=f.getLastWrite();
+    if(f.size()!=src->size || mtime!=src->mtime){ indexUpdate(src->path, f.size(), mtime); etag=etagFor(*src); }
+    // If-Range z innym ETagiem (lub datą) oznacza zmieniony plik – wtedy cała zawartość
+    size_t size=f.size(), start=0, len=size; int range=0;
+    String ifRange=_server.header("If-Range");
+    if(ifRange.length()==0 || ifRange==etag) range=wififs::parseRange(_server.header("Range").c_str(), size, start, len);
+    if(range<0){ f.close(); validators(); _server.sendHeader("Content-Range", String("bytes */")+String((unsigned long)size)); _server.send(416,"text/plain",""); return true; }
+    if(_concurrent && len>=ASYNC_MIN_SIZE && !freeTransfer()){ f.close(); _transfersRejected++; _server.sendHeader("Retry-After","1"); _server.send(503,"text/plain","Serwer zajęty, spróbuj ponownie"); return true; }
+    // Błąd seek() po wysłaniu nagłówków zostawiłby klienta z 200/206 bez treści
+    if(start && !f.seek(start)){ f.close(); _server.send(500,"text/plain","Błąd odczytu pliku"); return true; }
+    validators();
+    if(range>0) _server.sendHeader("Content-Range", String("bytes ")+String((unsigned long)start)+"-"+String((unsigned long)(start+len-1))+"/"+String((unsigned long)size));
+    if(src==gz) _server.sendHeader("Content-Encoding","gzip");
+    sendFileBody(f, range>0 ? 206 : 200, m.type, start, len); return true;
+}
+
+// Wysyła len bajtów od start (plik już ustawiony na start) i zamyka go; odczyty po pierwszym są wyrównane do bloku FILE_BUF_SIZE.
+// W trybie współbieżnym duże treści przechodzą do wolnego slotu Transfer i są dosyłane z handle().
+void WiFiFSManager::sendFileBody(File& f, int code, const char* type, size_t start, size_t len){
+    _server.setContentLength(len); _server.send(code, type, "");
+    if(!len){ f.close(); return; }
+    Transfer* t=(_concurrent && len>=ASYNC_MIN_SIZE) ? freeTransfer() : nullptr;
+    if(t) t->buf.reset(new (std::nothrow) uint8_t[FILE_BUF_SIZE]);
+    if(t && t->buf){
+        t->client=_server.client(); t->file=f; f=File();
+        t->pos=start; t->remaining=len; t->bufPos=t->bufLen=0; t->lastProgress=millis(); t->route=_currentRoute; t->active=true;
+        // stop() zwalnia tylko uchwyt WebServera – gniazdo żyje, dopóki trzyma je kopia w Transfer
+        _server.client().stop();
+        return; }
+    std::unique_ptr<uint8_t[]> heap(new (std::nothrow) uint8_t[FILE_BUF_SIZE]); uint8_t small[512];
+    uint8_t* buf=heap ? heap.get() : small; size_t cap=heap ? FILE_BUF_SIZE : sizeof(small);
+    WiFiClient& client=_server.client(); size_t pos=start;
+    while(len){ size_t n=cap-(pos%cap); if(n>len) n=len;
+        n=f.read(buf,n); if(n==0) break;
+        if(client.write(buf,n)!=n) break;
+        _server.countBytesOut(n);
+        pos+=n; len-=n; }
+    f.close();
+}
 
-void WiFiFSManager::handleFileView(){ String path=_server.arg("path"); if(path.length()==0 || !LittleFS.exists(path)){ _server.send(404,"text/html","<html><body><h3>Plik nie istnieje</h3></body></html>"); return;} String ct=contentTypeFor(path); File f=LittleFS.open(path,"r"); _server.streamFile(f,ct); f.close(); }
+WiFiFSManager::Transfer* WiFiFSManager::freeTransfer(){
+    if(activeTransfers()>=_maxTransfers) return nullptr;
+    for(auto& t : _transfers) if(!t->active) return t.get();
+    return nullptr;
+}
 
-void WiFiFSManager::handleFileDelete(){ if(!requireFileAuth()) return; String path=_server.arg("path"); path.trim(); if(path.length() && path[0]!='/') path = "/" + path; bool exists = LittleFS.exists(path); if(!exists && path.indexOf(' ')!=-1){ String alt = path; alt.replace(" ", "+"); if(LittleFS.exists(alt)){ path = alt; exists = true; } }
-    if(!exists){ _server.send(404,"text/plain","Nie znaleziono pliku"); if(_debug) Serial.printf("[WiFiFS] delete miss: '%s'\n", path.c_str()); return; } bool ok=LittleFS.remove(path); if(_debug) Serial.printf("[WiFiFS] usuwanie %s: %s\n", path.c_str(), ok?"OK":"FAILED"); _server.sendHeader("Location","/files",true); _server.send(302,"text/plain",""); }
+size_t WiFiFSManager::activeTransfers() const { size_t n=0; for(const auto& t : _transfers) if(t->active) n++; return n; }
+
+// Jeden nieblokujący send() na transfer w każdym obiegu handle(): wolne łącza nie zajmują pętli,
+// a handleClient() między obiegami obsługuje krótkie żądania.
+void WiFiFSManager::pumpTransfers(){
+    uint32_t now=millis();
+    for(auto& slot : _transfers){ Transfer& t=*slot; if(!t.active) continue;
+        if(t.bufPos==t.bufLen){
+            if(!t.remaining){ finishTransfer(t, true); continue; }
+            size_t n=FILE_BUF_SIZE-(t.pos%FILE_BUF_SIZE); if(n>t.remaining) n=t.remaining;
+            n=t.file.read(t.buf.get(), n); if(n==0){ finishTransfer(t, false); continue; }
+            t.bufPos=0; t.bufLen=n; t.pos+=n; t.remaining-=n; }
+        int sent=::send(t.client.fd(), t.buf.get()+t.bufPos, t.bufLen-t.bufPos, MSG_DONTWAIT);
+        if(sent>0){ t.bufPos+=sent; t.lastProgress=now; _metrics.addBytesOut(t.route, sent); }
+        else if((sent<0 && errno!=EAGAIN && errno!=EWOULDBLOCK) || now-t.lastProgress>=TRANSFER_IDLE_TIMEOUT_MS) finishTransfer(t, false);
+    }
+}
 
-void WiFiFSManager::handleFileUpload(){ if(!requireFileAuth()) return; HTTPUpload& upload=_server.upload(); static File up; if(upload.status==UPLOAD_FILE_START){ String filename=upload.filename; if(!filename.startsWith("/")) filename="/"+filename; up=LittleFS.open(filename,"w"); if(_debug) Serial.printf("[WiFiFS] upload start: %s\n", filename.c_str()); } else if(upload.status==UPLOAD_FILE_WRITE){ if(up) up.write(upload.buf, upload.currentSize); } else if(upload.status==UPLOAD_FILE_END){ if(up) up.close(); if(_debug) Serial.printf("[WiFiFS] upload end (%u bytes)\n", upload.totalSize); _server.sendHeader("Location","/files",true); _server.send(302,"text/plain",""); } else if(upload.status==UPLOAD_FILE_ABORTED){ if(up) up.close(); if(_debug) Serial.println(F("[WiFiFS] upload aborted")); _server.send(500,"text/plain","Upload przerwany"); } }
+void WiFiFSManager::finishTransfer(Transfer& t, bool ok){
+    if(_debug && !ok) Serial.printf("[WiFiFS] transfer przerwany (zostało %u B)\n", (unsigned)(t.remaining+t.bufLen-t.bufPos));
+    t.file.close(); t.client.stop(); t.buf.reset(); t.active=false;
+}
 
-void WiFiFSManager::handleWiFiSave(){ String mode=_server.arg("mode"); mode.trim(); String ssid=_server.arg("ssid"); ssid.trim(); String pass=_server.arg("pass"); pass.trim(); String apSsid=_server.arg("apSsid"); apSsid.trim(); String apPass=_server.arg("apPass"); apPass.trim(); if(mode!="STA" && mode!="AP") mode="AP"; _cfg.mode=mode; if(ssid.length()) _cfg.ssid=ssid; _cfg.pass=pass; if(apSsid.length()) _cfg.apSsid=apSsid; if(apPass.length()) _cfg.apPass=apPass; writeWiFiConfig(); if(mode=="STA") connectSTA(_cfg.ssid,_cfg.pass); else startAP(_cfg.apSsid,_cfg.apPass); _server.sendHeader("Location","/wifi",true); _server.send(302,"text/plain",""); }
+// ETag z walidatorów wpisu indeksu: czas zapisu, rozmiar i numer wersji. Numery startują od esp_random() przy
+// każdym uruchomieniu, więc ETag nie powtórzy się po restarcie ani po rescanIndex(), nawet bez RTC/NTP.
+String WiFiFSManager::etagFor(const FileEntry& e) const {
+    char b[40]; snprintf(b,sizeof(b),"\"%lx-%x-%08x\"",(unsigned long)e.mtime,(unsigned)e.size,(unsigned)e.gen); return String(b);
+}
 
-void WiFiFSManager::handleStaticOr404(){ String path=_server.uri(); if(LittleFS.exists(path)){ File f=LittleFS.open(path,"r"); _server.streamFile(f,contentTypeFor(path)); f.close(); } else { _server.send(404,"text/html","<!doctype html><html><body><h3>404 – Nie znaleziono</h3><p>"+path+"</p></body></html>"); } }
+void WiFiFSManager::handleStaticOr404(){ String path=_server.uri(); if(!serveFile(path, true)) _server.send(404,"text/html","<!doctype html><html><body><h3>404 – Nie znaleziono</h3><p>"+path+"</p></body></html>"); }
 
-bool WiFiFSManager::setWiFiSTA(const String& ssid, const String& pass){ _cfg.mode="STA"; _cfg.ssid=ssid; _cfg.pass=pass; writeWiFiConfig(); return connectSTA(ssid,pass);} 
+bool WiFiFSManager::setWiFiSTA(const String& ssid, const String& pass){ StateLock lock(_stateMutex); _cfg.mode="STA"; _cfg.ssid=ssid; _cfg.pass=pass; saveConfig(); _applyAt=millis()-WIFI_APPLY_DELAY_MS; _applyPending=true; return true;} 
 
-bool WiFiFSManager::setWiFiAP(const String& ssid, const String& pass){ _cfg.mode="AP"; _cfg.apSsid=ssid; _cfg.apPass=pass; writeWiFiConfig(); return startAP(ssid,pass);} 
+bool WiFiFSManager::setWiFiAP(const String& ssid, const String& pass){ StateLock lock(_stateMutex); _cfg.mode="AP"; _cfg.apSsid=ssid; _cfg.apPass=pass; saveConfig(); _applyAt=millis()-WIFI_APPLY_DELAY_MS; _applyPending=true; return true;} 
 
-void WiFiFSManager::setFileAuth(const String& user, const String& pass){ _fileAuthUser=user; _fileAuthPass=pass; writeAuthConfig(); }
+void WiFiFSManager::setFileAuth(const String& user, const String& pass){ StateLock lock(_stateMutex); _fileAuthUser=user; _fileAuthPass=pass; saveConfig(); }
 
-String WiFiFSManager::ipString() const{ if(_cfg.mode=="STA" && WiFi.status()==WL_CONNECTED) return WiFi.localIP().toString(); return WiFi.softAPIP().toString(); }
+String WiFiFSManager::ipString() const{ if(_linkState==LinkState::Connected) return WiFi.localIP().toString(); return WiFi.softAPIP().toString(); }
 
-WiFiFSManager::WiFiConfig WiFiFSManager::getConfig() const { return _cfg; }
+WiFiFSManager::WiFiConfig WiFiFSManager::getConfig() const { StateLock lock(_stateMutex); return _cfg; }
 
-void WiFiFSManager::printStatus() const{ Serial.printf("[WiFiFS] Tryb: %s\n", _cfg.mode.c_str()); if(_cfg.mode=="STA"){ Serial.printf("[WiFiFS] SSID: %s, status: %d, RSSI: %d dBm\n", _cfg.ssid.c_str(), WiFi.status(), WiFi.RSSI()); } else { Serial.printf("[WiFiFS] AP SSID: %s\n", _cfg.apSsid.c_str()); } Serial.printf("[WiFiFS] IP: %s\n", ipString().c_str()); Serial.printf("[WiFiFS] mDNS: %s.local\n", _mdnsHostname.c_str()); }
+void WiFiFSManager::printStatus() const{ WiFiConfig cfg=getConfig(); Serial.printf("[WiFiFS] Tryb: %s\n", cfg.mode.c_str()); if(cfg.mode=="STA"){ Serial.printf("[WiFiFS] SSID: %s, status: %d, RSSI: %d dBm\n", cfg.ssid.c_str(), WiFi.status(), WiFi.RSSI()); } else { Serial.printf("[WiFiFS] AP SSID: %s\n", cfg.apSsid.c_str()); } Serial.printf("[WiFiFS] Łącze: %s\n", linkStateName(_linkState)); Serial.printf("[WiFiFS] IP: %s\n", ipString().c_str()); Serial.printf("[WiFiFS] mDNS: %s.local\n", _mdnsHostname.c_str()); }
@@ -4,9 +4,44 @@
 #include <WebServer.h>
 #include <LittleFS.h>
 #include <ESPmDNS.h>
+#include "WiFiFSMetrics.h"
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 class WiFiFSManager {
 public:
+    // Rozmiar bufora wyjściowego strumieniowanych odpowiedzi (chunked)
+    static constexpr size_t CHUNK_BUF_SIZE = 1024;
+    // Bufor scalający zapisy uploadu – jeden blok flash LittleFS
+    static constexpr size_t UPLOAD_BUF_SIZE = 4096;
+    // Bufor odczytu przy wysyłaniu plików (wyrównany do bloku flash)
+    static constexpr size_t FILE_BUF_SIZE = 4096;
+    // Tryb współbieżny: pliki od tego rozmiaru wysyłane są w tle z handle()
+    static constexpr size_t ASYNC_MIN_SIZE = 16384;
+    // Transfer bez postępu przez ten czas jest zrywany
+    static constexpr uint32_t TRANSFER_IDLE_TIMEOUT_MS = 10000;
+    // Liczba wierszy na jednej stronie /files
+    static constexpr size_t FILES_PAGE_SIZE = 100;
+
+    // Czas na pojedynczą próbę połączenia STA i granice wykładniczego backoffu
+    static constexpr uint32_t WIFI_CONNECT_TIMEOUT_MS = 15000;
+    static constexpr uint32_t WIFI_BACKOFF_MIN_MS = 1000;
+    static constexpr uint32_t WIFI_BACKOFF_MAX_MS = 60000;
+
+    // Stan łącza: AP – tylko punkt dostępowy, pozostałe dotyczą STA (w trakcie łączenia działa też AP)
+    enum class LinkState : uint8_t { AP, Connecting, Connected, Backoff };
+
+    // Wpis indeksu metadanych LittleFS
+    struct FileEntry {
+        String path;
+        uint32_t size;
+        uint32_t mtime; // czas ostatniego zapisu z LittleFS (0 = nieznany)
+        uint32_t gen;   // numer wersji wpisu z _etagGen, niepowtarzalny między restartami
+        uint8_t mime;   // indeks w tabeli typów MIME
+    };
+
     struct WiFiConfig {
         String mode; // "STA" lub "AP"
         String ssid;
@@ -16,6 +51,7 @@ public:
     };
 
     explicit WiFiFSManager(uint16_t port = 80, bool debug = true);
+    ~WiFiFSManager();
 
     bool begin(const char* defaultApSsid = "ESP32_AP",
                const char* defaultApPass = "12345678",
@@ -24,39 +60,131 @@ public:
 
     void handle();
 
+    // Współbieżna obsługa klientów: duże pliki są wysyłane nieblokująco z handle() (po kawałku na połączenie
+    // w każdym obiegu), więc wolny klient nie blokuje krótkich żądań. Gdy wszystkie maxTransfers slotów są zajęte,
+    // kolejne duże pobrania dostają 503 z Retry-After.
+    void setConcurrentMode(bool enable, uint8_t maxTransfers = 4);
+
+    // Zmiana trybu jest wykonywana w handle(), a łączenie STA jest asynchroniczne –
+    // postęp widać w linkState() i /api/status.json. Można wołać z innych zadań.
     bool setWiFiSTA(const String& ssid, const String& pass);
     bool setWiFiAP(const String& ssid, const String& pass);
 
     void setFileAuth(const String& user, const String& pass);
 
+    // Własne klucze aplikacji w tym samym rekordzie konfiguracji; zapis tylko przy zmianie wartości
+    bool setUserValue(const String& key, const String& value);
+    String getUserValue(const String& key, const String& def = "") const;
+
+    // Indeks plików z begin() śledzi zmiany robione przez panel. Szkic, który sam tworzy, dopisuje lub usuwa
+    // pliki, zgłasza je przez notifyFileChanged(); rescanIndex() przebudowuje cały indeks (np. po wielu zmianach).
+    // Można wołać z innych zadań – indeks zmienia tylko handle(), przy następnym obiegu.
+    void notifyFileChanged(const String& path);
+    void rescanIndex();
+
     String ipString() const;
+    LinkState linkState() const { return _linkState; }
+    static const char* linkStateName(LinkState s);
+    uint32_t reconnectCount() const { return _reconnects; }
+    const WiFiFSMetrics& metrics() const { return _metrics; }
+    // Żądania dłuższe niż próg trafiają do bufora wolnych żądań w /api/metrics.json
+    void setSlowRequestThresholdMs(uint32_t ms) { _metrics.setSlowThresholdMs(ms); }
     WiFiConfig getConfig() const;
     void printStatus() const;
 
 private:
-    WebServer _server;
+    class ChunkWriter;
+    struct UploadSession;
+    struct Transfer;
+    typedef std::lock_guard<std::recursive_mutex> StateLock;
+    // Zwraca false, gdy klucz szablonu nie jest obsługiwany
+    typedef std::function<bool(ChunkWriter&, const char* key)> TemplateFiller;
+
+    MeteredWebServer _server;
+    WiFiFSMetrics _metrics;
+    uint32_t _reqStartUs = 0;
+    bool _reqActive = false;
+    uint8_t _currentRoute = 0;
     bool _debug;
     WiFiConfig _cfg;
+    // Chroni _cfg, dane logowania, _userCfg i _indexPending przed dostępem z innych zadań
+    mutable std::recursive_mutex _stateMutex;
 
     String _fileAuthUser;
     String _fileAuthPass;
 
     String _mdnsHostname;
 
+    struct LinkTransition { uint32_t at; LinkState from; LinkState to; };
+    static constexpr size_t LINK_HISTORY = 8;
+
+    std::atomic<LinkState> _linkState{LinkState::AP}; // czytany także z innych zadań (linkState(), ipString())
+    uint32_t _linkSince = 0;
+    uint32_t _attemptStart = 0;
+    uint32_t _nextAttempt = 0;
+    uint32_t _backoffMs = WIFI_BACKOFF_MIN_MS;
+    uint32_t _attempts = 0;
+    std::atomic<uint32_t> _reconnects{0};
+    uint32_t _transitions = 0;
+    LinkTransition _linkHistory[LINK_HISTORY] = {};
+    std::atomic<uint8_t> _wifiEvents{0}; // ustawiane z zadania zdarzeń WiFi
+    struct UserValue { String key; String value; };
+    std::vector<UserValue> _userCfg;
+    // Stan zatwierdzonego rekordu konfiguracji (dwa sloty, zapis do starszego)
+    uint32_t _cfgSeq = 0;
+    uint8_t _cfgSlot = 1;
+    bool _cfgValid = false;
+    uint32_t _cfgPayloadCrc = 0;
+    size_t _cfgPayloadLen = 0;
+
+    std::unique_ptr<UploadSession> _upload; // przesyłanie w bieżącym żądaniu
+    std::atomic<bool> _applyPending{false};
+    std::atomic<uint32_t> _applyAt{0};
+
+    std::vector<std::unique_ptr<Transfer>> _transfers;
+    uint8_t _maxTransfers = 0;
+    bool _concurrent = false;
+    uint32_t _transfersRejected = 0;
+
+    // Indeks należy do zadania wołającego handle(); inne zadania tylko kolejkują zmiany w _indexPending
+    std::vector<FileEntry> _index; // posortowany wg ścieżki
+    std::vector<String> _indexPending;
+    std::atomic<bool> _indexDirty{false};
+    std::atomic<bool> _rescanPending{false};
+    size_t _usedBytes = 0;
+    uint32_t _etagGen; // następny numer wersji wpisu; start losowy przy każdym uruchomieniu
+
     bool mountFS(bool formatIfFail);
     void ensureDefaultWebFiles();
-    bool readWiFiConfig();
-    bool writeWiFiConfig();
-    bool readAuthConfig();
-    bool writeAuthConfig();
-    String contentTypeFor(const String& path) const;
+    bool readWiFiConfig();  // import z dawnego KonfigWiFi.txt
+    bool readAuthConfig();  // import z dawnego KonfigAuth.txt
+    bool loadConfig();
+    bool saveConfig();
+    String* configField(const char* key);
+    uint8_t mimeIndexFor(const String& path) const;
+    const char* contentTypeFor(const String& path) const;
     String humanSize(size_t bytes) const;
+    void sendPage(const char* title, const char* h1, const char* nav, const char* body, const TemplateFiller& fill);
 
     bool startWiFiFromConfig(const char* defaultApSsid, const char* defaultApPass);
-    bool connectSTA(const String& ssid, const String& pass);
+    bool connectSTA();
     bool startAP(const String& ssid, const String& pass);
+    bool applyWiFiConfig();
+    void beginAttempt();
+    void setLinkState(LinkState s);
+    void updateLink();
 
     void setupRoutes();
+    WebServer::THandlerFunction metered(const char* route, WebServer::THandlerFunction fn);
+    WebServer::THandlerFunction meteredUpload(WebServer::THandlerFunction fn, bool raw);
+    void endRequest(uint8_t route);
+
+    // Operacje LittleFS z pomiarem czasu
+    File fsOpen(const String& path, const char* mode, bool create = false);
+    bool fsExists(const String& path);
+    bool fsRemove(const String& path);
+    bool fsRename(const String& from, const String& to);
+
     void handleRoot();
     void handleFilesPage();
     void handleWiFiPage();
@@ -65,13 +193,40 @@ private:
     void handleFileList();
     void handleFileListJson();
     void handleStatusJson();
+    void handleMetrics();
+    void handleMetricsJson();
     void handleFileView();
     void handleFileDelete();
+    void handleFileRename();
     void handleFileUpload();
+    void handleFilePut();
+    void handleFilePutDone();
+    bool commitUpload(UploadSession& u);
     void handleWiFiSave();
     void handleStaticOr404();
+    bool serveFile(const String& path, bool negotiateGzip);
+    String etagFor(const FileEntry& e) const;
+    void sendFileBody(File& f, int code, const char* type, size_t start, size_t len);
+    Transfer* freeTransfer();
+    size_t activeTransfers() const;
+    void pumpTransfers();
+    void finishTransfer(Transfer& t, bool ok);
 
     bool ensureFileAuth();
+    bool checkFileAuth();
     bool requireFileAuth();
-    size_t calcUsedBytes();
+
+    void applyIndexChanges();
+    void refreshEntry(const String& path);
+    void rebuildIndex(bool dropParts);
+    void indexDir(const String& dirPath, std::vector<String>* parts);
+    size_t indexLowerBound(const String& path) const;
+    FileEntry* indexFind(const String& path);
+    // Jak indexFind, ale przy braku wpisu sprawdza LittleFS i dopisuje plik utworzony poza panelem
+    FileEntry* indexLookup(const String& path);
+    void indexUpdate(const String& path, size_t size, uint32_t mtime = 0);
+    void indexRemove(const String& path);
+    void indexRename(const String& from, const String& to);
+    // Indeksy wpisów w kolejności sortowania ("name" lub "size")
+    std::vector<uint32_t> indexOrder(const String& sort, bool desc) const;
 };
@@ -0,0 +1,71 @@
+#include "WiFiFSMetrics.h"
+
+const uint16_t WiFiFSMetrics::LATENCY_BOUNDS_MS[WiFiFSMetrics::LATENCY_BUCKETS] = { 1, 2, 5, 10, 25, 50, 100, 250, 500, 1000, 2500 };
+
+const char* WiFiFSMetrics::fsOpName(FsOp op) {
+    switch (op) {
+        case FS_OPEN: return "open";
+        case FS_EXISTS: return "exists";
+        case FS_REMOVE: return "remove";
+        case FS_RENAME: return "rename";
+        default: return "?";
+    }
+}
+
+WiFiFSMetrics::WiFiFSMetrics() : _heapLow(UINT32_MAX), _slow(), _slowNext(0) {
+    for (Route& r : _routes) {
+        r.name = nullptr; r.count = 0; r.latencySumMs = 0; r.latencyRemUs = 0; r.bytesIn = 0; r.bytesOut = 0;
+        for (auto& s : r.status) s = 0;
+        for (auto& b : r.latency) b = 0;
+    }
+    for (FsCounter& c : _fs) { c.count = 0; c.sumUs = 0; c.maxUs = 0; }
+}
+
+uint8_t WiFiFSMetrics::addRoute(const char* name) {
+    if (_routeCount < MAX_ROUTES) { _routes[_routeCount].name = name; return _routeCount++; }
+    _routes[MAX_ROUTES - 1].name = "other";
+    return MAX_ROUTES - 1;
+}
+
+void WiFiFSMetrics::record(uint8_t route, int status, uint32_t us, uint32_t bytesIn, uint32_t bytesOut) {
+    if (route >= _routeCount) return;
+    Route& r = _routes[route];
+    uint32_t ms = us / 1000;
+    r.count.fetch_add(1, std::memory_order_relaxed);
+    r.status[(status >= 100 && status < 600) ? status / 100 : 0].fetch_add(1, std::memory_order_relaxed);
+    // Koszyk z pełnej wartości w µs – 1,9 ms nie może trafić do le="0.001"
+    size_t b = 0;
+    while (b < LATENCY_BUCKETS && us > LATENCY_BOUNDS_MS[b] * 1000u) b++;
+    r.latency[b].fetch_add(1, std::memory_order_relaxed);
+    // Ułamki milisekund sumują się w latencyRemUs, więc suma nie jest zaniżana o średnio 0,5 ms na żądanie
+    uint32_t rem = r.latencyRemUs.fetch_add(us % 1000, std::memory_order_relaxed) + us % 1000, carry = rem / 1000;
+    if (carry) r.latencyRemUs.fetch_sub(carry * 1000, std::memory_order_relaxed);
+    r.latencySumMs.fetch_add(ms + carry, std::memory_order_relaxed);
+    r.bytesIn.fetch_add(bytesIn, std::memory_order_relaxed);
+    r.bytesOut.fetch_add(bytesOut, std::memory_order_relaxed);
+    if (us >= _slowMs * 1000) {
+        uint32_t slot = _slowNext.fetch_add(1, std::memory_order_relaxed) % SLOW_RING;
+        _slow[slot] = { millis(), ms, (uint16_t)status, route };
+    }
+}
+
+void WiFiFSMetrics::recordFs(FsOp op, uint32_t us) {
+    FsCounter& c = _fs[op];
+    c.count.fetch_add(1, std::memory_order_relaxed);
+    c.sumUs.fetch_add(us, std::memory_order_relaxed);
+    uint32_t prev = c.maxUs.load(std::memory_order_relaxed);
+    while (us > prev && !c.maxUs.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {}
+}
+
+void WiFiFSMetrics::sampleHeap() {
+    uint32_t free = ESP.getFreeHeap();
+    uint32_t prev = _heapLow.load(std::memory_order_relaxed);
+    while (free < prev && !_heapLow.compare_exchange_weak(prev, free, std::memory_order_relaxed)) {}
+}
+
+bool WiFiFSMetrics::slowRequest(size_t i, SlowRequest& out) const {
+    uint32_t n = _slowNext.load(std::memory_order_relaxed);
+    if (i >= SLOW_RING || i >= n) return false;
+    out = _slow[(n - 1 - i) % SLOW_RING];
+    return true;
+}
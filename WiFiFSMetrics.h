@@ -0,0 +1,95 @@
+#pragma once
+#include <Arduino.h>
+#include <WebServer.h>
+#include <atomic>
+
+// Liczniki pracy serwera: wszystko w prealokowanych tablicach atomowych liczników 32-bit,
+// bez alokacji i blokad na ścieżce żądania. Liczniki bajtów i sum czasu zawijają się po 2^32.
+class WiFiFSMetrics {
+public:
+    static constexpr size_t MAX_ROUTES = 24;
+    static constexpr size_t LATENCY_BUCKETS = 11;  // + koszyk "+Inf"
+    static constexpr size_t SLOW_RING = 8;
+    static const uint16_t LATENCY_BOUNDS_MS[LATENCY_BUCKETS];
+
+    enum FsOp : uint8_t { FS_OPEN, FS_EXISTS, FS_REMOVE, FS_RENAME, FS_OP_COUNT };
+    static const char* fsOpName(FsOp op);
+
+    struct Route {
+        const char* name;
+        std::atomic<uint32_t> count;
+        std::atomic<uint32_t> status[6];  // 1xx..5xx, [0] = inne
+        std::atomic<uint32_t> latency[LATENCY_BUCKETS + 1];
+        std::atomic<uint32_t> latencySumMs;
+        std::atomic<uint32_t> latencyRemUs;  // reszta sumy poniżej 1 ms, przenoszona do latencySumMs
+        std::atomic<uint32_t> bytesIn;
+        std::atomic<uint32_t> bytesOut;
+    };
+
+    struct FsCounter {
+        std::atomic<uint32_t> count;
+        std::atomic<uint32_t> sumUs;
+        std::atomic<uint32_t> maxUs;
+    };
+
+    struct SlowRequest {
+        uint32_t at;      // millis() zakończenia
+        uint32_t ms;
+        uint16_t status;
+        uint8_t route;
+    };
+
+    WiFiFSMetrics();
+
+    // Rejestracja trasy przy starcie; zwraca jej identyfikator (ostatni wolny slot przy przepełnieniu)
+    uint8_t addRoute(const char* name);
+    void record(uint8_t route, int status, uint32_t us, uint32_t bytesIn, uint32_t bytesOut);
+    // Bajty dosłane po zakończeniu handlera (transfery w tle)
+    void addBytesOut(uint8_t route, uint32_t n) { if (route < _routeCount) _routes[route].bytesOut.fetch_add(n, std::memory_order_relaxed); }
+    void recordFs(FsOp op, uint32_t us);
+    void sampleHeap();
+
+    size_t routeCount() const { return _routeCount; }
+    const Route& route(size_t i) const { return _routes[i]; }
+    const FsCounter& fs(FsOp op) const { return _fs[op]; }
+    uint32_t heapLowWater() const { return _heapLow; }
+    uint32_t slowThresholdMs() const { return _slowMs; }
+    void setSlowThresholdMs(uint32_t ms) { _slowMs = ms; }
+    // Kopia i-tego najnowszego wolnego żądania (0 = ostatnie); false, gdy brak
+    bool slowRequest(size_t i, SlowRequest& out) const;
+
+private:
+    Route _routes[MAX_ROUTES];
+    size_t _routeCount = 0;
+    FsCounter _fs[FS_OP_COUNT];
+    std::atomic<uint32_t> _heapLow;
+    uint32_t _slowMs = 250;
+    SlowRequest _slow[SLOW_RING];
+    std::atomic<uint32_t> _slowNext;
+};
+
+// WebServer zapamiętujący kod i rozmiar odpowiedzi bieżącego żądania.
+// Przesłania metody wysyłające używane przez WiFiFSManager (wywołania idą przez typ pochodny).
+class MeteredWebServer : public WebServer {
+public:
+    explicit MeteredWebServer(int port) : WebServer(port) {}
+
+    void send(int code, const char* content_type = nullptr, const String& content = String("")) {
+        _lastStatus = code; _bytesOut += content.length(); WebServer::send(code, content_type, content);
+    }
+    void sendContent(const char* content, size_t len) { _bytesOut += len; WebServer::sendContent(content, len); }
+    void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+    void requestAuthentication(HTTPAuthMethod mode = BASIC_AUTH, const char* realm = nullptr, const String& authFailMsg = String("")) {
+        _lastStatus = 401; WebServer::requestAuthentication(mode, realm, authFailMsg);
+    }
+    // Dla treści zapisywanej bezpośrednio do client()
+    void countBytesOut(size_t n) { _bytesOut += n; }
+
+    void resetResponseStats() { _lastStatus = 0; _bytesOut = 0; }
+    int lastStatus() const { return _lastStatus; }
+    uint32_t bytesOut() const { return _bytesOut; }
+
+private:
+    int _lastStatus = 0;
+    uint32_t _bytesOut = 0;
+};
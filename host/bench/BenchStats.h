@@ -0,0 +1,48 @@
+#pragma once
+// Wspólne dla benchmarków: próbki czasu, percentyle i jeden wiersz tabeli wyników
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace bench {
+
+inline uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Stats {
+    const char* name;
+    std::vector<uint64_t> ns;  // czas pojedynczej operacji (lub średni w serii)
+    uint64_t ops = 0;          // liczba operacji, 0 = jedna na próbkę
+    uint64_t bytes = 0;        // przesłane/przetworzone bajty
+    uint64_t allocs = 0;       // alokacje w mierzonym kodzie
+    uint64_t wallNs = 0;       // czas całej serii
+    uint32_t errors = 0;
+
+    explicit Stats(const char* n) : name(n) {}
+    void add(uint64_t t) { ns.push_back(t); }
+    uint64_t pct(double p) const {
+        if (ns.empty()) return 0;
+        std::vector<uint64_t> s(ns); std::sort(s.begin(), s.end());
+        size_t i = (size_t)(p / 100.0 * (s.size() - 1) + 0.5);
+        return s[i];
+    }
+};
+
+inline void printHeader(const char* unit) {
+    printf("%-22s %7s %9s %9s %9s %9s %11s %10s %9s %6s\n", "scenariusz", "n", "p50", "p90", "p99", "max", "op/s", "MB/s", "alok/op", "błędy");
+    printf("%-22s %7s %9s %9s %9s %9s %11s %10s %9s %6s\n", "", "", unit, unit, unit, unit, "", "", "", "");
+}
+
+// div: 1000 dla µs, 1 dla ns
+inline void printRow(const Stats& s, uint64_t div) {
+    uint64_t n = s.ops ? s.ops : s.ns.size();
+    double secs = s.wallNs / 1e9;
+    printf("%-22s %7llu %9.1f %9.1f %9.1f %9.1f %11.0f %10.2f %9.2f %6u\n", s.name, (unsigned long long)n,
+           s.pct(50) / (double)div, s.pct(90) / (double)div, s.pct(99) / (double)div, s.pct(100) / (double)div,
+           secs > 0 ? n / secs : 0.0, secs > 0 ? s.bytes / secs / 1e6 : 0.0, n ? (double)s.allocs / n : 0.0, s.errors);
+}
+
+} // namespace bench
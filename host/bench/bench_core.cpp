@@ -0,0 +1,161 @@
+// Testy i pomiary funkcji z WiFiFSCore oraz liczników WiFiFSMetrics (bez zastępników sieci i systemu plików).
+//   bench_core [--iters N] [--files N]
+// Najpierw sprawdza poprawność (kod wyjścia 1 przy błędzie), potem drukuje tabelę pomiarów.
+#include "WiFiFSCore.h"
+#include "WiFiFSMetrics.h"
+#include "HostHeap.h"
+#include "BenchStats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+using namespace wififs;
+
+static int g_failed = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); g_failed++; } } while (0)
+
+static void checkRange(const char* h, size_t size, int want, size_t wantStart = 0, size_t wantLen = 0) {
+    size_t start = 0, len = 0;
+    int r = parseRange(h, size, start, len);
+    if (r != want || (r > 0 && (start != wantStart || len != wantLen))) {
+        printf("FAIL parseRange(\"%s\", %zu) = %d [%zu,+%zu], oczekiwano %d [%zu,+%zu]\n", h, size, r, start, len, want, wantStart, wantLen);
+        g_failed++;
+    }
+}
+
+// Wyjście szablonu jak ChunkWriter: stały bufor, zliczanie bajtów
+struct Sink {
+    char buf[1024];
+    size_t len = 0;
+    size_t total = 0;
+    void write(const char* p, size_t n) {
+        while (n) { size_t k = std::min(n, sizeof(buf) - len); memcpy(buf + len, p, k); len += k; p += k; n -= k; total += k; if (len == sizeof(buf)) len = 0; }
+    }
+    void print(const char* s) { write(s, strlen(s)); }
+};
+
+static void selfTest() {
+    checkRange("bytes=0-99", 1000, 1, 0, 100);
+    checkRange("bytes=100-", 1000, 1, 100, 900);
+    checkRange("bytes=-100", 1000, 1, 900, 100);
+    checkRange("bytes=-5000", 1000, 1, 0, 1000);
+    checkRange("bytes=900-5000", 1000, 1, 900, 100);
+    checkRange("bytes=1000-", 1000, -1);
+    checkRange("bytes=-0", 1000, -1);
+    checkRange("bytes=5-2", 1000, 0);
+    checkRange("bytes=0-1,5-6", 1000, 0);
+    checkRange("items=0-1", 1000, 0);
+    checkRange("", 1000, 0);
+    checkRange("bytes=abc-", 1000, 0);
+    checkRange("bytes=10-x", 1000, 0);
+    checkRange("bytes=-1x", 1000, 0);
+    checkRange("bytes=--5", 1000, 0);
+    checkRange("bytes= 10 - 19 ", 1000, 1, 10, 10);
+
+    CHECK(!strcmp(MIME_TABLE[mimeIndexFor("/a/index.HTML", 13)].type, "text/html"));
+    CHECK(!strcmp(MIME_TABLE[mimeIndexFor("/log.csv", 8)].type, "text/plain"));
+    CHECK(mimeIndexFor("/dir.d/noext", 12) == MIME_DEFAULT);
+    CHECK(mimeIndexFor("/x.verylongext", 14) == MIME_DEFAULT);
+
+    CHECK(crc32(0, (const uint8_t*)"123456789", 9) == 0xCBF43926u);
+
+    std::string out;
+    struct { std::string& o; void write(const char* p, size_t n) { o.append(p, n); } } str{ out };
+    renderTemplate("a%X%b%Y%c 100% %lower% %%", str, [&](const char* k) { if (strcmp(k, "X")) return false; out += "1"; return true; });
+    CHECK(out == "a1b%Y%c 100% %lower% %%");
+
+    uint8_t rec[512]; ConfigWriter w(rec, sizeof(rec));
+    CHECK(w.put("wifi.ssid", "dom", 3) && w.put("user.k", "", 0));
+    size_t len = w.finish(7); CHECK(len > CONFIG_HEADER_SIZE);
+    uint32_t seq = 0; const uint8_t* p = nullptr; size_t plen = 0;
+    CHECK(parseConfigRecord(rec, len, seq, p, plen) && seq == 7);
+    int entries = 0; CHECK(forEachConfigEntry(p, plen, [&](const char* k, size_t kl, const char* v, size_t vl) {
+        entries++; if (kl == 9) CHECK(!memcmp(k, "wifi.ssid", 9) && vl == 3 && !memcmp(v, "dom", 3)); }));
+    CHECK(entries == 2);
+    rec[len - 1] ^= 1; CHECK(!parseConfigRecord(rec, len, seq, p, plen));
+    CHECK(!parseConfigRecord(rec, CONFIG_HEADER_SIZE - 1, seq, p, plen));
+    ConfigWriter small(rec, 20); CHECK(!small.put("wifi.ssid", "dom", 3) && small.finish(1) == 0);
+
+    // Koszyki histogramu wg pełnego czasu w µs, suma bez gubienia ułamków milisekund
+    WiFiFSMetrics m; uint8_t r = m.addRoute("/x");
+    m.record(r, 200, 1000, 0, 0); m.record(r, 200, 1900, 0, 0); m.record(r, 200, 2001, 0, 0);
+    const WiFiFSMetrics::Route& mr = m.route(r);
+    CHECK(mr.latency[0] == 1 && mr.latency[1] == 1 && mr.latency[2] == 1);
+    CHECK(mr.latencySumMs == 4 && mr.latencyRemUs == 901);
+}
+
+// Powtarza fn w seriach po batch wywołań; próbka = średni czas wywołania w serii
+template <class Fn>
+static void measure(bench::Stats& s, size_t iters, size_t batch, size_t bytesPerOp, Fn fn) {
+    uint64_t a0 = host::allocCount(), t0 = bench::nowNs();
+    for (size_t i = 0; i < iters; i += batch) {
+        uint64_t t = bench::nowNs();
+        for (size_t k = 0; k < batch; k++) fn(i + k);
+        s.add((bench::nowNs() - t) / batch);
+    }
+    s.wallNs = bench::nowNs() - t0;
+    s.ops = s.ns.size() * batch;
+    s.allocs = host::allocCount() - a0;
+    s.bytes += bytesPerOp * s.ops;
+}
+
+int main(int argc, char** argv) {
+    size_t iters = 200000, files = 500;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--iters")) iters = strtoul(argv[i + 1], nullptr, 10);
+        else if (!strcmp(argv[i], "--files")) files = strtoul(argv[i + 1], nullptr, 10);
+    }
+    selfTest();
+    if (g_failed) { printf("bench_core: %d błędów\n", g_failed); return 1; }
+    printf("bench_core: testy OK\n\n");
+    host::setAllocCounting(true);
+    const size_t batch = 100;
+    if (iters < batch) iters = batch;
+
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < files; i++) { char b[48]; snprintf(b, sizeof(b), "/logi/2025/czujnik_%05zu.csv", i); paths.push_back(b); }
+
+    bench::printHeader("ns");
+    volatile size_t sink = 0;
+
+    { bench::Stats s("parseRange");
+      static const char* H[] = { "bytes=0-1023", "bytes=4096-", "bytes=-512", "bytes=99999999-" };
+      measure(s, iters, batch, 0, [&](size_t i) { size_t a, b; sink += parseRange(H[i & 3], 1 << 20, a, b); });
+      bench::printRow(s, 1); }
+
+    { bench::Stats s("mimeIndexFor");
+      measure(s, iters, batch, 0, [&](size_t i) { const std::string& p = paths[i % files]; sink += mimeIndexFor(p.c_str(), p.size()); });
+      bench::printRow(s, 1); }
+
+    { bench::Stats s("crc32 4 KB");
+      static uint8_t block[4096]; memset(block, 0xA5, sizeof(block));
+      measure(s, iters / 100, batch / 10, sizeof(block), [&](size_t) { sink += crc32(0, block, sizeof(block)); });
+      bench::printRow(s, 1); }
+
+    { char name[32]; snprintf(name, sizeof(name), "lista %zu wierszy", files);
+      bench::Stats s(name); Sink out;
+      size_t reps = std::max<size_t>(10, iters / files / 10);
+      measure(s, reps, 1, 0, [&](size_t) {
+          out.total = 0;
+          for (const std::string& p : paths)
+              renderTemplate(TPL_FILE_ROW, out, [&](const char* k) {
+                  if (!strcmp(k, "PATH") || !strcmp(k, "SAFEPATH")) { out.write(p.data(), p.size()); return true; }
+                  if (!strcmp(k, "SIZE")) { out.print("1.00 KB"); return true; }
+                  return false; });
+          s.bytes += out.total; });
+      bench::printRow(s, 1); }
+
+    { bench::Stats s("rekord konfiguracji");
+      static uint8_t rec[2048];
+      measure(s, iters / 10, batch, 0, [&](size_t i) {
+          ConfigWriter w(rec, sizeof(rec));
+          w.put("wifi.mode", "STA", 3); w.put("wifi.ssid", "siec-domowa", 11); w.put("wifi.pass", "tajnehaslo", 10);
+          w.put("wifi.apSsid", "ESP32_AP", 8); w.put("wifi.apPass", "12345678", 8); w.put("auth.user", "files", 5); w.put("auth.pass", "files123", 8);
+          size_t len = w.finish(i); uint32_t seq; const uint8_t* p; size_t plen;
+          if (parseConfigRecord(rec, len, seq, p, plen)) forEachConfigEntry(p, plen, [&](const char*, size_t kl, const char*, size_t vl) { sink += kl + vl; }); });
+      bench::printRow(s, 1); }
+
+    printf("\n(czas: ns na wywołanie, dla listy na całą listę; MB/s = przetworzone dane)\n");
+    return sink == 0xFFFFFFFF;
+}
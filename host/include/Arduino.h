@@ -0,0 +1,75 @@
+#pragma once
+// Minimalny zastępnik rdzenia Arduino-ESP32 dla builda na hoście (Linux).
+// Zawiera tylko to, czego używa WiFiFSManager; zachowanie jak na ESP32 tam, gdzie ma to wpływ na wyniki.
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <memory>
+#include "WString.h"
+
+#define PROGMEM
+#define PGM_P const char*
+#define F(s) (s)
+#define FPSTR(s) (s)
+
+using std::min;
+using std::max;
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* p, size_t n) { size_t k = 0; while (k < n && write(p[k])) k++; return k; }
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+    size_t print(long v) { return printf("%ld", v); }
+    size_t println(const char* s = "") { return print(s) + print("\r\n"); }
+    size_t println(const String& s) { return print(s) + print("\r\n"); }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    String readStringUntil(char term) { String s; int c; while ((c = read()) >= 0 && c != term) s += (char)c; return s; }
+    void setTimeout(unsigned long) {}
+};
+
+// Serial pisze na stdout
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+    size_t write(const uint8_t* p, size_t n) override { return fwrite(p, 1, n, stdout); }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+};
+extern HardwareSerial Serial;
+
+// 32 bity jak na ESP32 – kod opiera się na zawijaniu liczników czasu
+uint32_t millis();
+uint32_t micros();
+void delay(unsigned long ms);
+void yield();
+
+// Jak esp_random() z ESP-IDF (esp_system.h, dołączany przez Arduino.h na ESP32)
+uint32_t esp_random();
+
+// Sterta symulowana: HOST_HEAP_SIZE minus bajty żywych alokacji procesu (patrz HostHeap.h)
+class EspClass {
+public:
+    uint32_t getHeapSize();
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap() { return getFreeHeap(); }
+};
+extern EspClass ESP;
@@ -0,0 +1,12 @@
+#pragma once
+#include <Arduino.h>
+
+// Na hoście mDNS nic nie ogłasza
+class MDNSResponder {
+public:
+    bool begin(const char* hostname) { return hostname && *hostname; }
+    void end() {}
+    bool addService(const char*, const char*, uint16_t) { return true; }
+};
+
+extern MDNSResponder MDNS;
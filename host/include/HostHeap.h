@@ -0,0 +1,26 @@
+#pragma once
+// Liczniki alokacji hosta (globalne operator new/delete w src/Arduino.cpp).
+// Liczone są tylko alokacje wątku, który włączył liczenie – benchmark włącza je w wątku serwera,
+// a zastępniki WebServera wyłączają je na czas własnej pracy, więc wynik dotyczy kodu WiFiFSManager.
+#include <stdint.h>
+#include <stddef.h>
+
+namespace host {
+
+static const size_t HOST_HEAP_SIZE = 320 * 1024;  // rząd wielkości wolnej sterty ESP32 po starcie
+
+void setAllocCounting(bool on);
+bool allocCounting();
+uint64_t allocCount();      // liczba wywołań operator new w wątkach z włączonym liczeniem
+size_t liveBytes();         // bajty żywych alokacji całego procesu
+
+// Wyłącza liczenie w bieżącym wątku do końca zakresu
+class AllocPause {
+public:
+    AllocPause() : _was(allocCounting()) { setAllocCounting(false); }
+    ~AllocPause() { setAllocCounting(_was); }
+private:
+    bool _was;
+};
+
+} // namespace host
@@ -0,0 +1,11 @@
+#pragma once
+#include <Arduino.h>
+
+class IPAddress {
+public:
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : _b{a, b, c, d} {}
+    String toString() const { char s[16]; snprintf(s, sizeof(s), "%u.%u.%u.%u", _b[0], _b[1], _b[2], _b[3]); return String(s); }
+    uint8_t operator[](int i) const { return _b[i]; }
+private:
+    uint8_t _b[4];
+};
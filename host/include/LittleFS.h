@@ -0,0 +1,18 @@
+#pragma once
+#include <FS.h>
+
+namespace fs {
+
+class LittleFSFS : public FS {
+public:
+    // Tworzy katalog główny, jeśli go nie ma (odpowiednik formatowania)
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10, const char* partitionLabel = "spiffs");
+    void end() { _mounted = false; }
+    bool format();
+    size_t totalBytes();
+    size_t usedBytes();
+};
+
+} // namespace fs
+
+extern fs::LittleFSFS LittleFS;
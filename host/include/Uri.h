@@ -0,0 +1,16 @@
+#pragma once
+#include <Arduino.h>
+
+// Jak w ESP32 WebServer: bazowy Uri dopasowuje ścieżkę dokładnie, podklasy mogą to zmienić
+class Uri {
+protected:
+    const String _uri;
+
+public:
+    Uri(const char* uri) : _uri(uri) {}
+    Uri(const String& uri) : _uri(uri) {}
+    virtual ~Uri() {}
+    virtual Uri* clone() const { return new Uri(_uri); }
+    virtual void initPathArgs(std::vector<String>&) {}
+    virtual bool canHandle(const String& requestUri, std::vector<String>&) { return _uri == requestUri; }
+};
@@ -0,0 +1,80 @@
+#pragma once
+// Zastępnik Arduino String na bazie std::string (hostowy build WiFiFSManager)
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <strings.h>
+
+class String {
+public:
+    String(const char* s = "") : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    explicit String(char c) : _s(1, c) {}
+    explicit String(int v, unsigned char base = 10) : _s(num((long)v, base)) {}
+    explicit String(unsigned int v, unsigned char base = 10) : _s(unum(v, base)) {}
+    explicit String(long v, unsigned char base = 10) : _s(num(v, base)) {}
+    explicit String(unsigned long v, unsigned char base = 10) : _s(unum(v, base)) {}
+    explicit String(double v, unsigned int decimals = 2);
+
+    String& operator+=(const String& s) { _s += s._s; return *this; }
+    String& operator+=(const char* s) { _s += s; return *this; }
+    String& operator+=(char c) { _s += c; return *this; }
+    String& operator+=(int v) { _s += num(v, 10); return *this; }
+    String& operator+=(unsigned long v) { _s += unum(v, 10); return *this; }
+    bool concat(const char* s, unsigned int n) { _s.append(s, n); return true; }
+    bool concat(const String& s) { _s += s._s; return true; }
+
+    friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+    friend String operator+(const String& a, const char* b) { return String(a._s + b); }
+    friend String operator+(const char* a, const String& b) { return String(a + b._s); }
+    friend String operator+(const String& a, char b) { return String(a._s + b); }
+
+    bool operator==(const String& s) const { return _s == s._s; }
+    bool operator==(const char* s) const { return _s == s; }
+    bool operator!=(const String& s) const { return _s != s._s; }
+    bool operator!=(const char* s) const { return _s != s; }
+    bool operator<(const String& s) const { return _s < s._s; }
+    char operator[](unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+    char& operator[](unsigned int i) { return _s[i]; }
+
+    unsigned int length() const { return _s.size(); }
+    const char* c_str() const { return _s.c_str(); }
+    bool reserve(unsigned int n) { _s.reserve(n); return true; }
+    bool isEmpty() const { return _s.empty(); }
+
+    bool startsWith(const String& p) const { return _s.compare(0, p._s.size(), p._s) == 0; }
+    bool startsWith(const String& p, unsigned int off) const { return off <= _s.size() && _s.compare(off, p._s.size(), p._s) == 0; }
+    bool endsWith(const String& p) const { return _s.size() >= p._s.size() && _s.compare(_s.size() - p._s.size(), p._s.size(), p._s) == 0; }
+    bool equalsIgnoreCase(const String& s) const { return _s.size() == s._s.size() && strcasecmp(c_str(), s.c_str()) == 0; }
+
+    int indexOf(char c, unsigned int from = 0) const { return pos(_s.find(c, from)); }
+    int indexOf(const String& s, unsigned int from = 0) const { return pos(_s.find(s._s, from)); }
+    int indexOf(const char* s, unsigned int from = 0) const { return pos(_s.find(s, from)); }
+    int lastIndexOf(char c) const { return pos(_s.rfind(c)); }
+    int lastIndexOf(const String& s) const { return pos(_s.rfind(s._s)); }
+
+    String substring(unsigned int from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) { unsigned int t = from; from = to; to = t; }
+        if (from >= _s.size()) return String();
+        return String(_s.substr(from, to - from));
+    }
+
+    void replace(const String& find, const String& with);
+    void replace(char find, char with) { for (char& c : _s) if (c == find) c = with; }
+    void trim();
+    void toLowerCase() { for (char& c : _s) c = tolower((unsigned char)c); }
+    void toUpperCase() { for (char& c : _s) c = toupper((unsigned char)c); }
+    void remove(unsigned int from) { if (from < _s.size()) _s.erase(from); }
+    void remove(unsigned int from, unsigned int n) { if (from < _s.size()) _s.erase(from, n); }
+
+    long toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+    int compareTo(const String& s) const { return _s.compare(s._s); }
+
+private:
+    std::string _s;
+    static int pos(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+    static std::string num(long v, unsigned char base) { return v < 0 ? "-" + unum(0ul - (unsigned long)v, base) : unum(v, base); }
+    static std::string unum(unsigned long v, unsigned char base);
+};
@@ -0,0 +1,126 @@
+#pragma once
+// Zastępnik ESP32 WebServer na gniazdach POSIX. Odwzorowuje to, od czego zależą pomiary:
+// jeden klient na wywołanie handleClient(), Connection: close, chunked przy CONTENT_LENGTH_UNKNOWN,
+// upload multipart (HTTPUpload) dla POST i surowe ciało (HTTPRaw) dla pozostałych metod z obsługą uploadu.
+#include <Arduino.h>
+#include <WiFi.h>
+#include <FS.h>
+#include <Uri.h>
+#include <string>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+enum HTTPRawStatus { RAW_START, RAW_WRITE, RAW_END, RAW_ABORTED };
+enum HTTPAuthMethod { BASIC_AUTH, DIGEST_AUTH };
+
+#define HTTP_DOWNLOAD_UNIT_SIZE 1436
+#define HTTP_UPLOAD_BUFLEN 1436
+#define HTTP_RAW_BUFLEN 1436
+#define HTTP_MAX_DATA_WAIT 5000
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+typedef struct {
+    HTTPUploadStatus status;
+    String filename;
+    String name;
+    String type;
+    size_t totalSize;
+    size_t currentSize;
+    uint8_t buf[HTTP_UPLOAD_BUFLEN];
+} HTTPUpload;
+
+typedef struct {
+    HTTPRawStatus status;
+    size_t totalSize;
+    size_t currentSize;
+    uint8_t buf[HTTP_RAW_BUFLEN];
+} HTTPRaw;
+
+class WebServer {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    explicit WebServer(int port = 80);
+    virtual ~WebServer();
+
+    void begin();
+    void close();
+    void handleClient();
+    // Tylko na hoście: port faktycznie nasłuchujący (przy port = 0 wybrany przez system)
+    int port() const { return _port; }
+
+    bool authenticate(const char* user, const char* pass);
+    void requestAuthentication(HTTPAuthMethod mode = BASIC_AUTH, const char* realm = nullptr, const String& authFailMsg = String(""));
+
+    void on(const Uri& uri, THandlerFunction fn) { on(uri, HTTP_ANY, fn); }
+    void on(const Uri& uri, HTTPMethod method, THandlerFunction fn) { on(uri, method, fn, THandlerFunction()); }
+    void on(const Uri& uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn);
+    void onNotFound(THandlerFunction fn) { _notFound = fn; }
+
+    String uri() const { return _uri; }
+    HTTPMethod method() const { return _method; }
+    WiFiClient& client() { return _client; }
+    HTTPUpload& upload() { return *_upload; }
+    HTTPRaw& raw() { return *_raw; }
+
+    String arg(const String& name) const;
+    String arg(int i) const { return i >= 0 && (size_t)i < _args.size() ? _args[i].value : String(); }
+    String argName(int i) const { return i >= 0 && (size_t)i < _args.size() ? _args[i].key : String(); }
+    int args() const { return _args.size(); }
+    bool hasArg(const String& name) const;
+
+    void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+    String header(const String& name) const;
+    bool hasHeader(const String& name) const;
+    size_t clientContentLength() const { return _clientContentLength; }
+
+    void send(int code, const char* content_type = nullptr, const String& content = String(""));
+    void send(int code, const String& content_type, const String& content) { send(code, content_type.c_str(), content); }
+    void send_P(int code, PGM_P content_type, PGM_P content, size_t contentLength);
+    void setContentLength(const size_t contentLength) { _contentLength = contentLength; }
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+    void sendContent(const char* content, size_t size);
+    void sendContent_P(PGM_P content, size_t size) { sendContent(content, size); }
+
+private:
+    struct Handler { std::unique_ptr<Uri> uri; HTTPMethod method; THandlerFunction fn; THandlerFunction ufn; };
+    struct KV { String key; String value; };
+
+    int _port;
+    int _listenFd = -1;
+    std::vector<Handler> _handlers;
+    THandlerFunction _notFound;
+    std::vector<String> _collect{ String("Authorization") };
+
+    WiFiClient _client;
+    HTTPMethod _method = HTTP_ANY;
+    String _uri;
+    std::vector<KV> _args;
+    std::vector<KV> _headers;
+    std::vector<KV> _responseHeaders;
+    size_t _clientContentLength = 0;
+    size_t _contentLength = CONTENT_LENGTH_NOT_SET;
+    bool _headersSent = false;
+    bool _chunked = false;
+    bool _countAllocs = false;
+    std::string _rbuf;  // odebrane, jeszcze nieprzetworzone bajty żądania
+    size_t _rpos = 0;
+    std::unique_ptr<HTTPUpload> _upload;
+    std::unique_ptr<HTTPRaw> _raw;
+
+    void resetRequest();
+    bool collected(const String& key) const;
+    bool fill();
+    bool readLine(String& line);
+    size_t readSome(uint8_t* buf, size_t n);
+    bool readBody(std::string& body, size_t len);
+    bool parseRequest(Handler*& handler);
+    void parseArgs(const String& data);
+    bool parseMultipart(Handler* h, const std::string& body, const String& boundary);
+    bool readRaw(Handler& h);
+    void callUpload(Handler& h);
+    void writeHeader(int code, const char* contentType, size_t contentLength);
+    void finalizeResponse();
+};
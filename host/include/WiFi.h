@@ -0,0 +1,63 @@
+#pragma once
+// Zastępnik WiFi: WiFiClient to prawdziwe gniazdo TCP, a WiFiClass symuluje radio –
+// AP startuje od razu, a STA łączy się przy pierwszym status() po begin() (adres 127.0.0.1).
+#include <Arduino.h>
+#include <IPAddress.h>
+
+typedef enum { WL_IDLE_STATUS = 0, WL_NO_SSID_AVAIL, WL_SCAN_COMPLETED, WL_CONNECTED, WL_CONNECT_FAILED, WL_CONNECTION_LOST, WL_DISCONNECTED } wl_status_t;
+typedef enum { WIFI_OFF, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+typedef enum { ARDUINO_EVENT_WIFI_STA_CONNECTED, ARDUINO_EVENT_WIFI_STA_DISCONNECTED, ARDUINO_EVENT_WIFI_STA_GOT_IP, ARDUINO_EVENT_WIFI_STA_LOST_IP, ARDUINO_EVENT_MAX } arduino_event_id_t;
+typedef arduino_event_id_t WiFiEvent_t;
+typedef union { int reserved; } WiFiEventInfo_t;
+typedef size_t wifi_event_id_t;
+
+// Jak na ESP32: kopie współdzielą gniazdo, stop() zwalnia tylko uchwyt tej kopii,
+// a gniazdo zamyka się, gdy zniknie ostatnia kopia.
+class WiFiClient : public Stream {
+public:
+    WiFiClient() {}
+    explicit WiFiClient(int fd);
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t size) override;  // blokujący, do końca lub błędu
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size);
+    int peek() override;
+    uint8_t connected();
+    void stop();
+    int fd() const;
+    operator bool() { return connected(); }
+    void setNoDelay(bool nodelay);
+
+private:
+    struct Socket;
+    std::shared_ptr<Socket> _sock;
+};
+
+class WiFiClass {
+public:
+    typedef std::function<void(arduino_event_id_t event, WiFiEventInfo_t info)> WiFiEventFuncCb;
+
+    bool mode(wifi_mode_t m) { _mode = m; return true; }
+    wifi_mode_t getMode() { return _mode; }
+    wl_status_t begin(const char* ssid, const char* pass = nullptr);
+    wl_status_t status();
+    bool disconnect(bool wifioff = false, bool eraseap = false);
+    bool setAutoReconnect(bool) { return true; }
+    bool softAP(const char* ssid, const char* pass = nullptr) { return ssid && *ssid && (!pass || !*pass || strlen(pass) >= 8); }
+    bool softAPdisconnect(bool = false) { return true; }
+    IPAddress localIP() { return _status == WL_CONNECTED ? IPAddress(127, 0, 0, 1) : IPAddress(); }
+    IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+    int8_t RSSI() { return _status == WL_CONNECTED ? -50 : 0; }
+    wifi_event_id_t onEvent(WiFiEventFuncCb cb, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+
+private:
+    wifi_mode_t _mode = WIFI_OFF;
+    wl_status_t _status = WL_DISCONNECTED;
+    bool _pending = false;
+    std::vector<WiFiEventFuncCb> _handlers;
+    void fire(arduino_event_id_t event);
+};
+
+extern WiFiClass WiFi;
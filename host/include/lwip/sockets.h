@@ -0,0 +1,8 @@
+#pragma once
+// Na hoście gniazda lwIP to gniazda POSIX
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <errno.h>
+#include <unistd.h>
@@ -0,0 +1,102 @@
+#include <Arduino.h>
+#include "HostHeap.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <new>
+#include <random>
+#include <stdarg.h>
+#include <malloc.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static const std::chrono::steady_clock::time_point START = std::chrono::steady_clock::now();
+
+uint32_t millis() { return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - START).count(); }
+uint32_t micros() { return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - START).count(); }
+void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void yield() { std::this_thread::yield(); }
+uint32_t esp_random() { static std::random_device rd; return rd(); }
+
+size_t Print::printf(const char* fmt, ...) {
+    char small[256]; va_list ap;
+    va_start(ap, fmt); int n = vsnprintf(small, sizeof(small), fmt, ap); va_end(ap);
+    if (n < 0) return 0;
+    if ((size_t)n < sizeof(small)) return write((const uint8_t*)small, n);
+    std::unique_ptr<char[]> big(new char[n + 1]);
+    va_start(ap, fmt); vsnprintf(big.get(), n + 1, fmt, ap); va_end(ap);
+    return write((const uint8_t*)big.get(), n);
+}
+
+String::String(double v, unsigned int decimals) { char b[64]; snprintf(b, sizeof(b), "%.*f", (int)decimals, v); _s = b; }
+
+std::string String::unum(unsigned long v, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    char b[72]; int i = sizeof(b); b[--i] = 0;
+    do { unsigned d = v % base; b[--i] = d < 10 ? '0' + d : 'a' + d - 10; v /= base; } while (v);
+    return std::string(b + i);
+}
+
+void String::replace(const String& find, const String& with) {
+    if (find._s.empty()) return;
+    size_t p = 0;
+    while ((p = _s.find(find._s, p)) != std::string::npos) { _s.replace(p, find._s.size(), with._s); p += with._s.size(); }
+}
+
+void String::trim() {
+    size_t a = 0, b = _s.size();
+    while (a < b && isspace((unsigned char)_s[a])) a++;
+    while (b > a && isspace((unsigned char)_s[b - 1])) b--;
+    _s = _s.substr(a, b - a);
+}
+
+// --- Liczniki sterty -------------------------------------------------------
+
+namespace host {
+
+static thread_local bool t_counting = false;
+static std::atomic<uint64_t> g_allocs{0};
+static std::atomic<size_t> g_live{0};
+static std::atomic<size_t> g_livePeak{0};
+
+void setAllocCounting(bool on) { t_counting = on; }
+bool allocCounting() { return t_counting; }
+uint64_t allocCount() { return g_allocs.load(); }
+size_t liveBytes() { return g_live.load(); }
+
+static void* allocate(size_t n) {
+    void* p = malloc(n ? n : 1);
+    if (!p) return nullptr;
+    size_t real = malloc_usable_size(p);
+    size_t live = g_live.fetch_add(real, std::memory_order_relaxed) + real;
+    size_t peak = g_livePeak.load(std::memory_order_relaxed);
+    while (live > peak && !g_livePeak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    if (t_counting) g_allocs.fetch_add(1, std::memory_order_relaxed);
+    return p;
+}
+
+static void release(void* p) {
+    if (!p) return;
+    g_live.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+    free(p);
+}
+
+static size_t livePeak() { return g_livePeak.load(); }
+
+} // namespace host
+
+void* operator new(size_t n) { void* p = host::allocate(n); if (!p) throw std::bad_alloc(); return p; }
+void* operator new[](size_t n) { void* p = host::allocate(n); if (!p) throw std::bad_alloc(); return p; }
+void* operator new(size_t n, const std::nothrow_t&) noexcept { return host::allocate(n); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { return host::allocate(n); }
+void operator delete(void* p) noexcept { host::release(p); }
+void operator delete[](void* p) noexcept { host::release(p); }
+void operator delete(void* p, size_t) noexcept { host::release(p); }
+void operator delete[](void* p, size_t) noexcept { host::release(p); }
+
+static uint32_t freeOf(size_t used) { return used >= host::HOST_HEAP_SIZE ? 0 : (uint32_t)(host::HOST_HEAP_SIZE - used); }
+
+uint32_t EspClass::getHeapSize() { return host::HOST_HEAP_SIZE; }
+uint32_t EspClass::getFreeHeap() { return freeOf(host::liveBytes()); }
+uint32_t EspClass::getMinFreeHeap() { return freeOf(host::livePeak()); }
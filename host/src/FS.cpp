@@ -0,0 +1,158 @@
+#include <FS.h>
+#include <LittleFS.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+fs::LittleFSFS LittleFS;
+
+namespace fs {
+
+// Otwarty plik (FILE*) albo katalog (DIR*) hosta wraz ze ścieżką w przestrzeni nazw LittleFS
+class FileImpl {
+public:
+    FILE* f = nullptr;
+    DIR* d = nullptr;
+    String path;      // "/a/b.txt"
+    String hostPath;  // "<root>/a/b.txt"
+    ~FileImpl() { closeAll(); }
+    void closeAll() { if (f) { fclose(f); f = nullptr; } if (d) { closedir(d); d = nullptr; } }
+};
+
+static void mkdirs(const String& hostFile) {
+    for (int i = hostFile.indexOf('/', 1); i > 0; i = hostFile.indexOf('/', i + 1)) ::mkdir(hostFile.substring(0, i).c_str(), 0755);
+}
+
+String FS::hostPath(const char* path) const {
+    String p = path ? path : "";
+    if (!p.startsWith("/")) p = "/" + p;
+    while (p.length() > 1 && p.endsWith("/")) p.remove(p.length() - 1);
+    return _root + (p == "/" ? String() : p);
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+    if (!_mounted || !path) return File();
+    String host = hostPath(path);
+    struct stat st;
+    bool exists = stat(host.c_str(), &st) == 0;
+    FileImplPtr impl = std::make_shared<FileImpl>();
+    impl->path = path[0] == '/' ? String(path) : "/" + String(path);
+    impl->hostPath = host;
+    if (exists && S_ISDIR(st.st_mode)) {
+        if (mode[0] != 'r') return File();
+        impl->d = opendir(host.c_str());
+        return impl->d ? File(impl) : File();
+    }
+    if (mode[0] == 'r' && !exists) return File();
+    if (create) mkdirs(host);
+    const char* m = mode[0] == 'r' ? (mode[1] == '+' ? "r+b" : "rb") : mode[0] == 'w' ? (mode[1] == '+' ? "w+b" : "wb") : (mode[1] == '+' ? "a+b" : "ab");
+    impl->f = fopen(host.c_str(), m);
+    return impl->f ? File(impl) : File();
+}
+
+bool FS::exists(const char* path) { struct stat st; return _mounted && stat(hostPath(path).c_str(), &st) == 0; }
+bool FS::remove(const char* path) { return _mounted && unlink(hostPath(path).c_str()) == 0; }
+bool FS::rename(const char* from, const char* to) { return _mounted && ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0; }
+bool FS::mkdir(const char* path) { return _mounted && (::mkdir(hostPath(path).c_str(), 0755) == 0 || errno == EEXIST); }
+bool FS::rmdir(const char* path) { return _mounted && ::rmdir(hostPath(path).c_str()) == 0; }
+
+size_t File::write(const uint8_t* buf, size_t size) { return (_p && _p->f) ? fwrite(buf, 1, size, _p->f) : 0; }
+
+size_t File::read(uint8_t* buf, size_t size) { return (_p && _p->f) ? fread(buf, 1, size, _p->f) : 0; }
+
+int File::read() { uint8_t c; return read(&c, 1) == 1 ? c : -1; }
+
+int File::peek() { if (!_p || !_p->f) return -1; int c = fgetc(_p->f); if (c != EOF) ungetc(c, _p->f); return c == EOF ? -1 : c; }
+
+int File::available() { if (!_p || !_p->f) return 0; size_t s = size(), p = position(); return p < s ? (int)(s - p) : 0; }
+
+void File::flush() { if (_p && _p->f) fflush(_p->f); }
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!_p || !_p->f) return false;
+    int whence = mode == SeekSet ? SEEK_SET : mode == SeekCur ? SEEK_CUR : SEEK_END;
+    return fseek(_p->f, pos, whence) == 0;
+}
+
+size_t File::position() const { return (_p && _p->f) ? (size_t)ftell(_p->f) : 0; }
+
+size_t File::size() const {
+    if (!_p || !_p->f) return 0;
+    fflush(_p->f);
+    struct stat st; return fstat(fileno(_p->f), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::close() { if (_p) _p->closeAll(); }
+
+File::operator bool() const { return _p && (_p->f || _p->d); }
+
+time_t File::getLastWrite() {
+    if (!_p) return 0;
+    struct stat st; return stat(_p->hostPath.c_str(), &st) == 0 ? st.st_mtime : 0;
+}
+
+const char* File::path() const { return _p ? _p->path.c_str() : nullptr; }
+
+const char* File::name() const {
+    if (!_p) return nullptr;
+    const char* p = _p->path.c_str(); const char* s = strrchr(p, '/');
+    return s ? s + 1 : p;
+}
+
+bool File::isDirectory() { return _p && _p->d; }
+
+File File::openNextFile(const char* mode) {
+    if (!_p || !_p->d) return File();
+    struct dirent* de;
+    while ((de = readdir(_p->d))) {
+        if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, "..")) continue;
+        String child = (_p->path == "/" ? String() : _p->path) + "/" + de->d_name;
+        return LittleFS.open(child, mode);
+    }
+    return File();
+}
+
+void File::rewindDirectory() { if (_p && _p->d) rewinddir(_p->d); }
+
+bool LittleFSFS::begin(bool formatOnFail, const char*, uint8_t, const char*) {
+    struct stat st;
+    if (stat(_root.c_str(), &st) != 0) {
+        if (!formatOnFail || ::mkdir(_root.c_str(), 0755) != 0) return false;
+    } else if (!S_ISDIR(st.st_mode)) return false;
+    _mounted = true;
+    return true;
+}
+
+static void removeTree(const String& dir) {
+    DIR* d = opendir(dir.c_str()); if (!d) return;
+    while (struct dirent* de = readdir(d)) {
+        if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, "..")) continue;
+        String p = dir + "/" + de->d_name; struct stat st;
+        if (stat(p.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) { removeTree(p); ::rmdir(p.c_str()); }
+        else unlink(p.c_str());
+    }
+    closedir(d);
+}
+
+bool LittleFSFS::format() { removeTree(_root); return true; }
+
+// Pojemność partycji "spiffs" z partitions.csv
+size_t LittleFSFS::totalBytes() { return 0xBF0000; }
+
+static size_t treeBytes(const String& dir) {
+    size_t n = 0; DIR* d = opendir(dir.c_str()); if (!d) return 0;
+    while (struct dirent* de = readdir(d)) {
+        if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, "..")) continue;
+        String p = dir + "/" + de->d_name; struct stat st;
+        if (stat(p.c_str(), &st) != 0) continue;
+        n += S_ISDIR(st.st_mode) ? treeBytes(p) : (size_t)st.st_size;
+    }
+    closedir(d);
+    return n;
+}
+
+size_t LittleFSFS::usedBytes() { return treeBytes(_root); }
+
+} // namespace fs
@@ -0,0 +1,334 @@
+#include <WebServer.h>
+#include "HostHeap.h"
+#include <lwip/sockets.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <signal.h>
+#include <string>
+
+WebServer::WebServer(int port) : _port(port) {}
+
+WebServer::~WebServer() { close(); }
+
+// Nasłuch tylko na 127.0.0.1 – build hostowy służy do pomiarów i testów lokalnych
+void WebServer::begin() {
+    signal(SIGPIPE, SIG_IGN);
+    _listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1; setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in a = {}; a.sin_family = AF_INET; a.sin_port = htons(_port); a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(_listenFd, (struct sockaddr*)&a, sizeof(a)) != 0 || ::listen(_listenFd, 64) != 0) {
+        fprintf(stderr, "[WebServer] bind/listen na porcie %d nie powiódł się\n", _port); ::close(_listenFd); _listenFd = -1; return;
+    }
+    socklen_t len = sizeof(a); getsockname(_listenFd, (struct sockaddr*)&a, &len); _port = ntohs(a.sin_port);
+}
+
+void WebServer::close() { if (_listenFd >= 0) { ::close(_listenFd); _listenFd = -1; } _client.stop(); }
+
+void WebServer::on(const Uri& uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn) {
+    _handlers.push_back(Handler{ std::unique_ptr<Uri>(uri.clone()), method, fn, ufn });
+}
+
+// Jak w ESP32 WebServer: header() widzi tylko nagłówki z collectHeaders() oraz Authorization
+void WebServer::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+    _collect.clear(); _collect.push_back("Authorization");
+    for (size_t i = 0; i < headerKeysCount; i++) _collect.push_back(headerKeys[i]);
+}
+
+bool WebServer::collected(const String& key) const {
+    for (const String& k : _collect) if (k.equalsIgnoreCase(key)) return true;
+    return false;
+}
+
+String WebServer::header(const String& name) const {
+    for (const KV& h : _headers) if (h.key.equalsIgnoreCase(name)) return h.value;
+    return String();
+}
+
+bool WebServer::hasHeader(const String& name) const {
+    for (const KV& h : _headers) if (h.key.equalsIgnoreCase(name)) return true;
+    return false;
+}
+
+String WebServer::arg(const String& name) const {
+    for (const KV& a : _args) if (a.key == name) return a.value;
+    return String();
+}
+
+bool WebServer::hasArg(const String& name) const {
+    for (const KV& a : _args) if (a.key == name) return true;
+    return false;
+}
+
+// Jeden klient na wywołanie, jak w ESP32 WebServer. Czas pracy samego zastępnika nie jest liczony
+// do alokacji (HostHeap.h) – liczniki wracają do stanu wywołującego tylko na czas handlerów.
+void WebServer::handleClient() {
+    if (_listenFd < 0) return;
+    bool counting = host::allocCounting();
+    host::AllocPause pause;
+    struct pollfd p = { _listenFd, POLLIN, 0 };
+    if (::poll(&p, 1, 0) <= 0) return;  // bez czekania, jak na ESP32 – pętla loop() kręci się w kółko
+    int fd = ::accept(_listenFd, nullptr, nullptr);
+    if (fd < 0) return;
+    struct timeval tv = { HTTP_MAX_DATA_WAIT / 1000, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    _client = WiFiClient(fd); _client.setNoDelay(true);
+    resetRequest();
+    _countAllocs = counting;
+    Handler* h = nullptr;
+    if (parseRequest(h)) {
+        THandlerFunction& fn = h ? h->fn : _notFound;
+        if (fn) { host::setAllocCounting(counting); fn(); host::setAllocCounting(false); }
+        else send(404, "text/plain", String("Not found: ") + _uri);
+        finalizeResponse();
+    }
+    _client = WiFiClient();
+    resetRequest();
+}
+
+void WebServer::resetRequest() {
+    _method = HTTP_ANY; _uri = String(); _args.clear(); _headers.clear(); _responseHeaders.clear();
+    _clientContentLength = 0; _contentLength = CONTENT_LENGTH_NOT_SET;
+    _headersSent = false; _chunked = false; _rbuf.clear(); _rpos = 0;
+}
+
+bool WebServer::fill() {
+    if (_rpos == _rbuf.size()) { _rbuf.clear(); _rpos = 0; }
+    char b[2048];
+    ssize_t n = ::recv(_client.fd(), b, sizeof(b), 0);
+    if (n <= 0) return false;
+    _rbuf.append(b, n);
+    return true;
+}
+
+bool WebServer::readLine(String& line) {
+    for (;;) {
+        size_t nl = _rbuf.find('\n', _rpos);
+        if (nl != std::string::npos) {
+            size_t end = (nl > _rpos && _rbuf[nl - 1] == '\r') ? nl - 1 : nl;
+            line = String(_rbuf.substr(_rpos, end - _rpos)); _rpos = nl + 1; return true;
+        }
+        if (_rbuf.size() - _rpos > 8192 || !fill()) return false;
+    }
+}
+
+size_t WebServer::readSome(uint8_t* buf, size_t n) {
+    if (_rpos == _rbuf.size() && !fill()) return 0;
+    size_t k = std::min(n, _rbuf.size() - _rpos);
+    memcpy(buf, _rbuf.data() + _rpos, k); _rpos += k;
+    return k;
+}
+
+bool WebServer::readBody(std::string& body, size_t len) {
+    body.resize(len);
+    for (size_t got = 0; got < len;) {
+        size_t n = readSome((uint8_t*)&body[got], len - got);
+        if (!n) return false;
+        got += n;
+    }
+    return true;
+}
+
+static String urlDecodeArg(const String& s) {
+    String out; out.reserve(s.length());
+    for (unsigned int i = 0; i < s.length(); i++) {
+        char c = s[i];
+        if (c == '+') out += ' ';
+        else if (c == '%' && i + 2 < s.length()) { char h[3] = { s[i + 1], s[i + 2], 0 }; out += (char)strtol(h, nullptr, 16); i += 2; }
+        else out += c;
+    }
+    return out;
+}
+
+void WebServer::parseArgs(const String& data) {
+    int pos = 0;
+    while (pos < (int)data.length()) {
+        int amp = data.indexOf('&', pos); if (amp < 0) amp = data.length();
+        String pair = data.substring(pos, amp); int eq = pair.indexOf('=');
+        if (pair.length()) _args.push_back(eq < 0 ? KV{ urlDecodeArg(pair), String() } : KV{ urlDecodeArg(pair.substring(0, eq)), urlDecodeArg(pair.substring(eq + 1)) });
+        pos = amp + 1;
+    }
+}
+
+static HTTPMethod methodFor(const String& m) {
+    if (m == "GET") return HTTP_GET;
+    if (m == "HEAD") return HTTP_HEAD;
+    if (m == "POST") return HTTP_POST;
+    if (m == "PUT") return HTTP_PUT;
+    if (m == "PATCH") return HTTP_PATCH;
+    if (m == "DELETE") return HTTP_DELETE;
+    if (m == "OPTIONS") return HTTP_OPTIONS;
+    return HTTP_ANY;
+}
+
+bool WebServer::parseRequest(Handler*& handler) {
+    String line;
+    if (!readLine(line)) return false;
+    int sp1 = line.indexOf(' '), sp2 = line.indexOf(' ', sp1 + 1);
+    if (sp1 < 0 || sp2 < 0) return false;
+    _method = methodFor(line.substring(0, sp1));
+    String url = line.substring(sp1 + 1, sp2);
+    int q = url.indexOf('?');
+    if (q >= 0) { parseArgs(url.substring(q + 1)); url = url.substring(0, q); }
+    _uri = url;
+
+    String contentType;
+    while (readLine(line) && line.length()) {
+        int colon = line.indexOf(':'); if (colon <= 0) continue;
+        String key = line.substring(0, colon), value = line.substring(colon + 1); value.trim();
+        if (key.equalsIgnoreCase("Content-Length")) _clientContentLength = value.toInt();
+        if (key.equalsIgnoreCase("Content-Type")) contentType = value;
+        if (collected(key)) _headers.push_back(KV{ key, value });
+    }
+
+    std::vector<String> pathArgs;
+    for (Handler& h : _handlers)
+        if ((h.method == HTTP_ANY || h.method == _method) && h.uri->canHandle(_uri, pathArgs)) { handler = &h; break; }
+
+    if (_method == HTTP_GET || _method == HTTP_HEAD) return true;
+    bool form = contentType.startsWith("application/x-www-form-urlencoded");
+    // Jak na ESP32: trasa z uploadem dostaje surowe ciało także przy Content-Length: 0 (np. PUT z Content-Range: bytes */n)
+    if (handler && handler->ufn && !form && !contentType.startsWith("multipart/form-data")) return readRaw(*handler);
+    if (!_clientContentLength && !contentType.length()) return true;
+    if (contentType.startsWith("multipart/form-data")) {
+        int b = contentType.indexOf("boundary="); std::string body;
+        if (b < 0 || !readBody(body, _clientContentLength)) return false;
+        String boundary = contentType.substring(b + 9); boundary.replace("\"", "");
+        return parseMultipart(handler && _method == HTTP_POST ? handler : nullptr, body, boundary);
+    }
+    std::string body;
+    if (!readBody(body, _clientContentLength)) return false;
+    if (form) parseArgs(String(body));
+    else _args.push_back(KV{ "plain", String(body) });
+    return true;
+}
+
+void WebServer::callUpload(Handler& h) { host::setAllocCounting(_countAllocs); h.ufn(); host::setAllocCounting(false); }
+
+// Ciało inne niż formularz dla trasy z uploadem: RAW_START, RAW_WRITE po HTTP_RAW_BUFLEN, RAW_END.
+// Zerwane połączenie kończy się RAW_ABORTED bez wywołania głównego handlera.
+bool WebServer::readRaw(Handler& h) {
+    _raw.reset(new HTTPRaw());
+    _raw->status = RAW_START; _raw->totalSize = 0; _raw->currentSize = 0;
+    callUpload(h);
+    size_t left = _clientContentLength;
+    while (left) {
+        size_t n = readSome(_raw->buf, std::min(left, (size_t)HTTP_RAW_BUFLEN));
+        if (!n) { _raw->status = RAW_ABORTED; _raw->currentSize = 0; callUpload(h); return false; }
+        _raw->status = RAW_WRITE; _raw->currentSize = n; _raw->totalSize += n; left -= n;
+        callUpload(h);
+    }
+    _raw->status = RAW_END; _raw->currentSize = 0;
+    callUpload(h);
+    return true;
+}
+
+// Pola tekstowe trafiają do args(), pliki do handlera uploadu porcjami HTTP_UPLOAD_BUFLEN
+bool WebServer::parseMultipart(Handler* h, const std::string& body, const String& boundary) {
+    std::string delim = std::string("--") + boundary.c_str();
+    size_t pos = body.find(delim);
+    while (pos != std::string::npos) {
+        pos += delim.size();
+        if (body.compare(pos, 2, "--") == 0) break;
+        size_t hdrEnd = body.find("\r\n\r\n", pos); if (hdrEnd == std::string::npos) return false;
+        String headers(body.substr(pos, hdrEnd - pos));
+        size_t dataStart = hdrEnd + 4;
+        size_t next = body.find("\r\n" + delim, dataStart); if (next == std::string::npos) return false;
+        auto param = [&](const char* key) {
+            String k = String(key) + "=\""; int i = headers.indexOf(k); if (i < 0) return String();
+            int e = headers.indexOf('"', i + k.length()); return headers.substring(i + k.length(), e);
+        };
+        String name = param("name"), filename = param("filename");
+        if (headers.indexOf("filename=") < 0) _args.push_back(KV{ name, String(body.substr(dataStart, next - dataStart)) });
+        else if (h && h->ufn) {
+            _upload.reset(new HTTPUpload());
+            HTTPUpload& u = *_upload;
+            u.filename = filename; u.name = name; u.totalSize = 0; u.currentSize = 0;
+            int ct = headers.indexOf("Content-Type:");
+            if (ct >= 0) { int e = headers.indexOf('\r', ct); u.type = headers.substring(ct + 13, e < 0 ? headers.length() : e); u.type.trim(); }
+            u.status = UPLOAD_FILE_START; callUpload(*h);
+            for (size_t p = dataStart; p < next;) {
+                size_t n = std::min(next - p, (size_t)HTTP_UPLOAD_BUFLEN);
+                memcpy(u.buf, body.data() + p, n); u.currentSize = n; u.status = UPLOAD_FILE_WRITE; callUpload(*h);
+                u.totalSize += n; p += n;
+            }
+            u.currentSize = 0; u.status = UPLOAD_FILE_END; callUpload(*h);
+        }
+        pos = body.find(delim, next + 2);
+    }
+    return true;
+}
+
+static int b64val(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    return c == '+' ? 62 : c == '/' ? 63 : -1;
+}
+
+bool WebServer::authenticate(const char* user, const char* pass) {
+    host::AllocPause pause;
+    String auth = header("Authorization");
+    if (!auth.startsWith("Basic ")) return false;
+    std::string decoded; uint32_t acc = 0; int bits = 0;
+    for (unsigned int i = 6; i < auth.length(); i++) {
+        int v = b64val(auth[i]); if (v < 0) continue;
+        acc = (acc << 6) | v; bits += 6;
+        if (bits >= 8) { bits -= 8; decoded += (char)((acc >> bits) & 0xFF); }
+    }
+    return decoded == std::string(user) + ":" + pass;
+}
+
+void WebServer::requestAuthentication(HTTPAuthMethod, const char* realm, const String& authFailMsg) {
+    sendHeader("WWW-Authenticate", String("Basic realm=\"") + (realm ? realm : "Login Required") + "\"");
+    send(401, "text/html", authFailMsg);
+}
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+    host::AllocPause pause;
+    if (first) _responseHeaders.insert(_responseHeaders.begin(), KV{ name, value });
+    else _responseHeaders.push_back(KV{ name, value });
+}
+
+static const char* reasonFor(int code) {
+    switch (code) {
+        case 200: return "OK"; case 201: return "Created"; case 204: return "No Content"; case 206: return "Partial Content";
+        case 301: return "Moved Permanently"; case 302: return "Found"; case 304: return "Not Modified"; case 308: return "Permanent Redirect";
+        case 400: return "Bad Request"; case 401: return "Unauthorized"; case 403: return "Forbidden"; case 404: return "Not Found";
+        case 409: return "Conflict"; case 416: return "Range Not Satisfiable"; case 500: return "Internal Server Error"; case 503: return "Service Unavailable";
+        default: return "";
+    }
+}
+
+void WebServer::writeHeader(int code, const char* contentType, size_t contentLength) {
+    std::string h = "HTTP/1.1 " + std::to_string(code) + " " + reasonFor(code) + "\r\n";
+    h += "Content-Type: "; h += contentType ? contentType : "text/html"; h += "\r\n";
+    if (_contentLength == CONTENT_LENGTH_NOT_SET) h += "Content-Length: " + std::to_string(contentLength) + "\r\n";
+    else if (_contentLength != CONTENT_LENGTH_UNKNOWN) h += "Content-Length: " + std::to_string(_contentLength) + "\r\n";
+    else { h += "Transfer-Encoding: chunked\r\n"; _chunked = true; }
+    h += "Connection: close\r\n";
+    for (const KV& kv : _responseHeaders) { h += kv.key.c_str(); h += ": "; h += kv.value.c_str(); h += "\r\n"; }
+    h += "\r\n";
+    _client.write((const uint8_t*)h.data(), h.size());
+    _responseHeaders.clear(); _contentLength = CONTENT_LENGTH_NOT_SET; _headersSent = true;
+}
+
+void WebServer::send(int code, const char* content_type, const String& content) {
+    host::AllocPause pause;
+    writeHeader(code, content_type, content.length());
+    if (content.length()) sendContent(content.c_str(), content.length());
+}
+
+void WebServer::send_P(int code, PGM_P content_type, PGM_P content, size_t contentLength) {
+    host::AllocPause pause;
+    writeHeader(code, content_type, contentLength);
+    if (contentLength) sendContent(content, contentLength);
+}
+
+void WebServer::sendContent(const char* content, size_t size) {
+    if (_chunked) { char b[16]; int n = snprintf(b, sizeof(b), "%zx\r\n", size); _client.write((const uint8_t*)b, n); }
+    if (size) _client.write((const uint8_t*)content, size);
+    if (_chunked) { _client.write((const uint8_t*)"\r\n", 2); if (!size) _chunked = false; }
+}
+
+void WebServer::finalizeResponse() { if (_chunked) sendContent("", 0); }
@@ -0,0 +1,95 @@
+#include <WiFi.h>
+#include <ESPmDNS.h>
+#include <lwip/sockets.h>
+#include <poll.h>
+
+WiFiClass WiFi;
+MDNSResponder MDNS;
+
+struct WiFiClient::Socket {
+    int fd;
+    int peeked = -1;
+    explicit Socket(int f) : fd(f) {}
+    ~Socket() { if (fd >= 0) ::close(fd); }
+};
+
+WiFiClient::WiFiClient(int fd) : _sock(std::make_shared<Socket>(fd)) {}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t size) {
+    if (!_sock) return 0;
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::send(_sock->fd, buf + done, size - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += n;
+    }
+    return done;
+}
+
+int WiFiClient::available() {
+    if (!_sock) return 0;
+    int n = 0;
+    struct pollfd p = { _sock->fd, POLLIN, 0 };
+    if (::poll(&p, 1, 0) > 0 && (p.revents & POLLIN)) {
+        uint8_t c; n = ::recv(_sock->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) > 0 ? 1 : 0;
+    }
+    return n + (_sock->peeked >= 0);
+}
+
+int WiFiClient::read(uint8_t* buf, size_t size) {
+    if (!_sock || !size) return -1;
+    size_t off = 0;
+    if (_sock->peeked >= 0) { buf[off++] = _sock->peeked; _sock->peeked = -1; if (off == size) return off; }
+    ssize_t n = ::recv(_sock->fd, buf + off, size - off, 0);
+    if (n <= 0) return off ? (int)off : -1;
+    return off + n;
+}
+
+int WiFiClient::read() { uint8_t c; return read(&c, 1) == 1 ? c : -1; }
+
+int WiFiClient::peek() {
+    if (!_sock) return -1;
+    if (_sock->peeked < 0) { uint8_t c; if (::recv(_sock->fd, &c, 1, 0) == 1) _sock->peeked = c; }
+    return _sock->peeked;
+}
+
+uint8_t WiFiClient::connected() {
+    if (!_sock) return 0;
+    struct pollfd p = { _sock->fd, POLLIN, 0 };
+    if (::poll(&p, 1, 0) > 0) {
+        if (p.revents & (POLLERR | POLLHUP | POLLNVAL)) return 0;
+        uint8_t c; if ((p.revents & POLLIN) && ::recv(_sock->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 0) return 0;
+    }
+    return 1;
+}
+
+void WiFiClient::stop() { _sock.reset(); }
+
+int WiFiClient::fd() const { return _sock ? _sock->fd : -1; }
+
+void WiFiClient::setNoDelay(bool nodelay) { if (_sock) { int v = nodelay; setsockopt(_sock->fd, IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v)); } }
+
+wl_status_t WiFiClass::begin(const char* ssid, const char*) {
+    _status = WL_DISCONNECTED; _pending = ssid && *ssid;
+    if (!_pending) _status = WL_NO_SSID_AVAIL;
+    return _status;
+}
+
+wl_status_t WiFiClass::status() {
+    if (_pending) { _pending = false; _status = WL_CONNECTED; fire(ARDUINO_EVENT_WIFI_STA_CONNECTED); fire(ARDUINO_EVENT_WIFI_STA_GOT_IP); }
+    return _status;
+}
+
+bool WiFiClass::disconnect(bool, bool) {
+    bool was = _status == WL_CONNECTED; _pending = false; _status = WL_DISCONNECTED;
+    if (was) fire(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    return true;
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb cb, arduino_event_id_t event) {
+    _handlers.push_back(event == ARDUINO_EVENT_MAX ? cb : [cb, event](arduino_event_id_t e, WiFiEventInfo_t i) { if (e == event) cb(e, i); });
+    return _handlers.size();
+}
+
+void WiFiClass::fire(arduino_event_id_t event) { WiFiEventInfo_t info = {}; for (auto& h : _handlers) h(event, info); }